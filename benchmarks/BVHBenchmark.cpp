@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+#include "BVH.h"
+#include "ThreadPool.h"
+#include "Timing.h"
+
+/* BVH build, frustum cull, raycast and refit over 10k, 100k and 1M random boxes, each once on the calling thread
+ * and once with a ThreadPool. cull() and raycast() take no pool, so with one a batch of independent queries is
+ * spread across it instead. Linear Frustum::cull over the same boxes is the baseline the tree has to beat */
+
+static constexpr size_t CAMERA_COUNT = 16;
+static constexpr size_t RAY_COUNT = 10000;
+static constexpr float WORLD_SIZE = 1000.f;
+
+struct Scene {
+    std::vector<AABB> bounds;
+    std::vector<AABB> moved;
+    std::vector<Frustum> cameras;
+    std::vector<std::pair<vec3, vec3>> rays;
+};
+
+static AABB randomBox(std::mt19937 &random, size_t count) {
+    std::uniform_real_distribution<float> position(0.f, WORLD_SIZE);
+    /* Boxes shrink with the count so the world stays about as full */
+    float size = WORLD_SIZE * 0.5f / std::cbrt((float) count);
+    std::uniform_real_distribution<float> extent(0.1f * size, size);
+    vec3 center = {position(random), position(random), position(random)};
+    AABB box{};
+    for (int axis = 0; axis < 3; axis++) {
+        float half = extent(random) * 0.5f;
+        box.min[axis] = center[axis] - half;
+        box.max[axis] = center[axis] + half;
+    }
+    return box;
+}
+
+static Scene makeScene(size_t count) {
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    Scene scene;
+    for (size_t i = 0; i < count; i++)
+        scene.bounds.push_back(randomBox(random, count));
+    for (size_t i = 0; i < count; i++)
+        scene.moved.push_back(randomBox(random, count));
+
+    /* Cameras inside the world looking in random directions, each seeing a few percent of it */
+    mat4x4 projection;
+    mat4x4_perspective(projection, 1.f, 16.f / 9.f, 0.1f, WORLD_SIZE * 0.5f);
+    for (size_t i = 0; i < CAMERA_COUNT; i++) {
+        vec3 eye = {WORLD_SIZE * (0.5f + 0.3f * uniform(random)), WORLD_SIZE * (0.5f + 0.3f * uniform(random)),
+                    WORLD_SIZE * (0.5f + 0.3f * uniform(random))};
+        vec3 center = {eye[0] + uniform(random), eye[1] + uniform(random), eye[2] + uniform(random)};
+        vec3 up = {0.f, 1.f, 0.f};
+        mat4x4 view, viewProjection;
+        mat4x4_look_at(view, eye, center, up);
+        mat4x4_mul(viewProjection, projection, view);
+        scene.cameras.emplace_back(viewProjection);
+    }
+
+    for (size_t i = 0; i < RAY_COUNT; i++) {
+        std::pair<vec3, vec3> ray;
+        vec3 direction = {uniform(random), uniform(random), uniform(random)};
+        for (int axis = 0; axis < 3; axis++)
+            ray.first[axis] = WORLD_SIZE * (0.5f + 0.5f * uniform(random));
+        vec3_norm(ray.second, direction);
+        scene.rays.push_back(ray);
+    }
+    return scene;
+}
+
+/* Runs [task] over [count] items, across [pool] in chunks of [grain] when there is one */
+static void forEach(ThreadPool *pool, size_t count, size_t grain, const std::function<void(size_t, size_t)> &task) {
+    if (pool)
+        pool->parallelFor(count, grain, task);
+    else
+        task(0, count);
+}
+
+static void run(const Scene &scene, ThreadPool *pool) {
+    size_t count = scene.bounds.size();
+    const char *mode = pool ? "pool" : "serial";
+    BVH bvh;
+
+    double build = bestOf(3, [&] { bvh.build(scene.bounds.data(), count, pool); });
+
+    std::vector<std::vector<uint32_t>> visible(CAMERA_COUNT);
+    double cull = bestOf(3, [&] {
+        forEach(pool, CAMERA_COUNT, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                visible[i].clear();
+                bvh.cull(scene.cameras[i], visible[i]);
+            }
+        });
+    });
+    size_t visibleCount = 0;
+    for (const std::vector<uint32_t> &objects: visible)
+        visibleCount += objects.size();
+
+    /* Frustum::cull is single-threaded either way, so it's only timed once */
+    std::vector<uint32_t> linearVisible(count);
+    double linear = pool ? 0. : bestOf(3, [&] {
+        for (const Frustum &camera: scene.cameras)
+            camera.cull(scene.bounds.data(), count, linearVisible.data());
+    });
+
+    std::vector<uint8_t> hits(RAY_COUNT);
+    double ray = bestOf(3, [&] {
+        forEach(pool, RAY_COUNT, 256, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                hits[i] = bvh.raycast(scene.rays[i].first, scene.rays[i].second).has_value();
+        });
+    });
+    size_t hitCount = 0;
+    for (uint8_t hit: hits)
+        hitCount += hit;
+
+    /* 1% of objects moving takes refit()'s ancestors-only path, all of them the whole-tree one */
+    size_t fewMoved = std::max<size_t>(count / 100, 1);
+    double refitFew = bestOf(3, [&] {
+        for (size_t i = 0; i < fewMoved; i++)
+            bvh.update((uint32_t) (i * 100 % count), scene.moved[i]);
+        bvh.refit(pool);
+    });
+    double refitAll = bestOf(3, [&] {
+        for (size_t i = 0; i < count; i++)
+            bvh.update((uint32_t) i, scene.moved[i]);
+        bvh.refit(pool);
+    });
+
+    printf("%8zu %-7s %9.2f ms %9.3f ms ", count, mode, build * 1e3, cull * 1e3 / CAMERA_COUNT);
+    if (pool)
+        printf("%12s ", "-");
+    else
+        printf("%9.3f ms ", linear * 1e3 / CAMERA_COUNT);
+    printf("%9.2f us %9.3f ms %9.3f ms   %zu visible, %zu hits\n", ray * 1e6 / RAY_COUNT, refitFew * 1e3,
+           refitAll * 1e3, visibleCount / CAMERA_COUNT, hitCount);
+}
+
+int main(int argc, char **argv) {
+    unsigned int threads = argc > 1 ? (unsigned int) strtoul(argv[1], nullptr, 10) : 0;
+    ThreadPool pool(threads ? threads : std::max(std::thread::hardware_concurrency(), 1u));
+    printf("Pool of %u threads; cull and linear are per camera, ray per ray, refit 1%% and 100%% moved\n",
+           pool.getThreadCount());
+    printf("%8s %-7s %12s %12s %12s %12s %12s %12s\n", "objects", "mode", "build", "cull", "linear", "ray",
+           "refit 1%", "refit 100%");
+    for (size_t count: {10000, 100000, 1000000}) {
+        Scene scene = makeScene(count);
+        run(scene, nullptr);
+        run(scene, &pool);
+    }
+    return EXIT_SUCCESS;
+}
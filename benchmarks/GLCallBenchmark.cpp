@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <cstdlib>
+#include "Headless.h"
+#include "GLCallLoop.h"
+#include "GLState.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Timing.h"
+#include "VertexArray.h"
+
+/* Time per GL call through GLCall with and without GLCALL_CHECKS, under each KHR_debug output mode. Runs on a
+ * debug context, like main.cpp's debug builds */
+
+static const char *CALL_VERTEX = R"(#version 330
+void main()
+{
+    gl_Position = vec4(float(gl_VertexID & 1) * 0.01, float(gl_VertexID >> 1) * 0.01, 0.0, 1.0);
+}
+)";
+
+static const char *CALL_FRAGMENT = R"(#version 330
+uniform float u_Value;
+out vec4 color;
+void main()
+{
+    color = vec4(u_Value);
+}
+)";
+
+enum class DebugOutput {
+    Off,
+    Asynchronous,
+    Synchronous,
+};
+
+static bool setDebugOutput(DebugOutput mode) {
+    if (mode == DebugOutput::Off) {
+        if (GLAD_GL_KHR_debug) {
+            GLCall(glDisable(GL_DEBUG_OUTPUT));
+        }
+        return true;
+    }
+    if (!GLEnableDebugOutput())
+        return false;
+    if (mode == DebugOutput::Synchronous) {
+        GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    } else {
+        GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    unsigned int count = argc > 1 ? (unsigned int) strtoul(argv[1], nullptr, 10) : 100000;
+    if (!createHeadlessContext(3, 3, 256, 256, true))
+        return EXIT_FAILURE;
+    printf("%s, %u calls per run\n", (const char *) glGetString(GL_RENDERER), count);
+    {
+        Shader shader(ShaderProgramSource{CALL_VERTEX, CALL_FRAGMENT}, "GL call benchmark");
+        shader.bind();
+        VertexArray vertexArray;
+        vertexArray.bind();
+
+        CallTarget target{};
+        GLCall(glGenBuffers(2, target.buffers));
+        target.uniformLocation = shader.getUniformLocation("u_Value");
+
+        const struct {
+            CallKind kind;
+            const char *name;
+        } kinds[] = {{CallKind::BindBuffer, "glBindBuffer"}, {CallKind::Uniform, "glUniform1f"},
+                     {CallKind::Draw, "glDrawArrays"}};
+        const struct {
+            DebugOutput mode;
+            const char *name;
+        } modes[] = {{DebugOutput::Off, "off"}, {DebugOutput::Asynchronous, "async"},
+                     {DebugOutput::Synchronous, "sync"}};
+
+        printf("%-14s %-14s %12s %12s\n", "call", "debug output", "unchecked", "checked");
+        for (auto [kind, kindName]: kinds) {
+            for (auto [mode, modeName]: modes) {
+                if (!setDebugOutput(mode)) {
+                    printf("%-14s %-14s %25s\n", kindName, modeName, "no KHR_debug");
+                    continue;
+                }
+                /* glFinish inside the timing keeps queued draws from spilling into the next run */
+                double unchecked = bestOf(5, [&] {
+                    issueUncheckedCalls(kind, target, count);
+                    glFinish();
+                });
+                double checked = bestOf(5, [&] {
+                    issueCheckedCalls(kind, target, count);
+                    glFinish();
+                });
+                printf("%-14s %-14s %9.1f ns %9.1f ns\n", kindName, modeName, unchecked * 1e9 / count,
+                       checked * 1e9 / count);
+            }
+        }
+        setDebugOutput(DebugOutput::Off);
+        /* The loops bind buffers behind GLState's back */
+        GLState::get().invalidate();
+        GLCall(glDeleteBuffers(2, target.buffers));
+    }
+    destroyHeadlessContext();
+    return EXIT_SUCCESS;
+}
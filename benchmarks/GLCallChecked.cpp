@@ -0,0 +1,22 @@
+#ifndef GLCALL_CHECKS
+#define GLCALL_CHECKS
+#endif
+
+#include "Renderer.h"
+#include "GLCallLoop.h"
+
+void issueCheckedCalls(CallKind kind, const CallTarget &target, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        switch (kind) {
+            case CallKind::BindBuffer:
+                GLCall(glBindBuffer(GL_ARRAY_BUFFER, target.buffers[i & 1]));
+                break;
+            case CallKind::Uniform:
+                GLCall(glUniform1f(target.uniformLocation, (float) i));
+                break;
+            case CallKind::Draw:
+                GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+                break;
+        }
+    }
+}
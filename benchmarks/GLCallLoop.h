@@ -0,0 +1,22 @@
+#ifndef OPENGL_GLCALLLOOP_H
+#define OPENGL_GLCALLLOOP_H
+
+/* GLCall expands as GLCALL_CHECKS was when Renderer.h was included, so the loops are compiled twice: once by
+ * GLCallChecked.cpp and once by GLCallUnchecked.cpp */
+
+enum class CallKind {
+    BindBuffer, /* Alternates between two buffers so no driver can skip it */
+    Uniform,    /* A float uniform on the bound program */
+    Draw,       /* One triangle */
+};
+
+struct CallTarget {
+    unsigned int buffers[2];
+    int uniformLocation;
+};
+
+/* Issues [count] calls of [kind] through GLCall */
+void issueCheckedCalls(CallKind kind, const CallTarget &target, unsigned int count);
+void issueUncheckedCalls(CallKind kind, const CallTarget &target, unsigned int count);
+
+#endif //OPENGL_GLCALLLOOP_H
@@ -0,0 +1,21 @@
+/* OPENGL_GLCALL_CHECKS defines it for the whole library */
+#undef GLCALL_CHECKS
+
+#include "Renderer.h"
+#include "GLCallLoop.h"
+
+void issueUncheckedCalls(CallKind kind, const CallTarget &target, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        switch (kind) {
+            case CallKind::BindBuffer:
+                GLCall(glBindBuffer(GL_ARRAY_BUFFER, target.buffers[i & 1]));
+                break;
+            case CallKind::Uniform:
+                GLCall(glUniform1f(target.uniformLocation, (float) i));
+                break;
+            case CallKind::Draw:
+                GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+                break;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "LinmathSIMD.h"
+#include "Timing.h"
+
+/* linmath's scalar functions against their simd:: versions over arrays of random inputs. Inputs and outputs
+ * stay in cache, so this is the arithmetic alone */
+
+static constexpr size_t COUNT = 4096;
+
+struct Inputs {
+    std::vector<mat4x4> matrices = std::vector<mat4x4>(COUNT);
+    std::vector<vec4> vectors = std::vector<vec4>(COUNT);
+    std::vector<quat> quaternions = std::vector<quat>(COUNT);
+
+    Inputs() {
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+        for (size_t i = 0; i < COUNT; i++) {
+            /* Diagonally dominant, so every matrix inverts */
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    matrices[i][column][row] = uniform(random) + (column == row ? 4.f : 0.f);
+            for (int k = 0; k < 4; k++)
+                vectors[i][k] = uniform(random);
+            vec4_norm(quaternions[i], vectors[i]);
+        }
+    }
+};
+
+/* Runs [scalar] and [vectorised] over the inputs and prints ns per call for each; the checksums keep the
+ * results alive and show the two agree */
+template<typename Scalar, typename Vectorised>
+static void compare(const char *name, size_t rounds, Scalar &&scalar, Vectorised &&vectorised) {
+    std::vector<mat4x4> output(COUNT);
+    auto checksum = [&] {
+        double sum = 0.;
+        for (const mat4x4 &m: output)
+            sum += m[0][0] + m[1][1] + m[2][2] + m[3][3];
+        return sum;
+    };
+
+    double scalarSeconds = bestOf(5, [&] {
+        for (size_t round = 0; round < rounds; round++)
+            scalar(output.data());
+    });
+    double scalarSum = checksum();
+    double vectorisedSeconds = bestOf(5, [&] {
+        for (size_t round = 0; round < rounds; round++)
+            vectorised(output.data());
+    });
+    double vectorisedSum = checksum();
+
+    double calls = (double) (rounds * COUNT);
+    printf("%-20s %9.2f ns %9.2f ns %7.2fx   checksums %.4g / %.4g\n", name, scalarSeconds * 1e9 / calls,
+           vectorisedSeconds * 1e9 / calls, scalarSeconds / vectorisedSeconds, scalarSum, vectorisedSum);
+}
+
+int main(int argc, char **argv) {
+    size_t rounds = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200;
+    Inputs in;
+    const mat4x4 *m = in.matrices.data();
+    vec4 *v = in.vectors.data();
+    quat *q = in.quaternions.data();
+
+    printf("simd implementation: %s, %zu calls per run\n", simd::getImplementation(), rounds * COUNT);
+    printf("%-20s %12s %12s %8s\n", "function", "scalar", "simd", "speedup");
+
+    compare("mat4x4_mul", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            mat4x4_mul(out[i], m[i], m[(i + 1) % COUNT]);
+    }, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            simd::mat4x4_mul(out[i], m[i], m[(i + 1) % COUNT]);
+    });
+    compare("mat4x4_mul_array", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            mat4x4_mul(out[i], m[0], m[i]);
+    }, [&](mat4x4 *out) {
+        simd::mat4x4_mul_array(out, m[0], m, COUNT);
+    });
+    compare("mat4x4_mul_vec4", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            mat4x4_mul_vec4(out[i][i & 3], m[i], v[i]);
+    }, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            simd::mat4x4_mul_vec4(out[i][i & 3], m[i], v[i]);
+    });
+    compare("mat4x4_invert", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            mat4x4_invert(out[i], m[i]);
+    }, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            simd::mat4x4_invert(out[i], m[i]);
+    });
+    compare("quat_mul", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            quat_mul(out[i][i & 3], q[i], q[(i + 1) % COUNT]);
+    }, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            simd::quat_mul(out[i][i & 3], q[i], q[(i + 1) % COUNT]);
+    });
+    compare("mat4x4_from_quat", rounds, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            mat4x4_from_quat(out[i], q[i]);
+    }, [&](mat4x4 *out) {
+        for (size_t i = 0; i < COUNT; i++)
+            simd::mat4x4_from_quat(out[i], q[i]);
+    });
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "ObjImporter.h"
+#include "ThreadPool.h"
+#include "Timing.h"
+
+/* importObj() throughput with and without a ThreadPool, on the OBJ given as the first argument or, without one,
+ * on a generated grid of quads with positions, texture coordinates and normals. The file is read once before
+ * timing, so it's parsing being measured rather than the disk */
+
+/* An [n] x [n] heightfield with per-vertex texture coordinates and normals, written the way exporters do:
+ * six significant digits and v/vt/vn faces, here quads for the importer to triangulate */
+static bool writeGrid(const std::filesystem::path &path, int n) {
+    std::ofstream stream(path);
+    char line[128];
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            float u = (float) x / (float) (n - 1), v = (float) y / (float) (n - 1);
+            float height = 0.1f * std::sin(u * 20.f) * std::cos(v * 20.f);
+            snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", u * 2.f - 1.f,
+                     height, v * 2.f - 1.f, u, v, -2.f * std::cos(u * 20.f) * std::cos(v * 20.f), 1.f,
+                     2.f * std::sin(u * 20.f) * std::sin(v * 20.f));
+            stream << line;
+        }
+    }
+    stream << "usemtl grid\n";
+    for (int y = 0; y + 1 < n; y++) {
+        for (int x = 0; x + 1 < n; x++) {
+            int a = y * n + x + 1, b = a + 1, c = a + n + 1, d = a + n;
+            snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+            stream << line;
+        }
+    }
+    return (bool) stream;
+}
+
+static void run(const std::filesystem::path &path, double megabytes, ThreadPool *pool) {
+    size_t vertices = 0, indices = 0;
+    double seconds = bestOf(3, [&] {
+        std::optional<ObjModel> model = importObj(path, pool);
+        vertices = model ? model->vertices.size() : 0;
+        indices = model ? model->indices.size() : 0;
+    });
+    printf("%-8s %8.1f ms %8.1f MB/s   %zu vertices, %zu indices\n", pool ? "pool" : "serial", seconds * 1e3,
+           megabytes / seconds, vertices, indices);
+}
+
+int main(int argc, char **argv) {
+    std::filesystem::path path;
+    bool generated = argc < 2;
+    if (generated) {
+        path = std::filesystem::temp_directory_path() / "ObjBenchmark.obj";
+        if (!writeGrid(path, 1000)) {
+            fprintf(stderr, "Error: couldn't write %s\n", path.c_str());
+            return EXIT_FAILURE;
+        }
+    } else {
+        path = argv[1];
+    }
+
+    std::error_code error;
+    double megabytes = (double) std::filesystem::file_size(path, error) / 1e6;
+    if (error) {
+        fprintf(stderr, "Error: couldn't read %s\n", path.c_str());
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool;
+    printf("%s, %.1f MB, pool of %u threads\n", path.c_str(), megabytes, pool.getThreadCount());
+    importObj(path); /* Brings the file into the page cache */
+    run(path, megabytes, nullptr);
+    run(path, megabytes, &pool);
+
+    if (generated)
+        std::filesystem::remove(path, error);
+    return EXIT_SUCCESS;
+}
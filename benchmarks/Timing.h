@@ -0,0 +1,19 @@
+#ifndef OPENGL_TIMING_H
+#define OPENGL_TIMING_H
+
+#include <algorithm>
+#include <chrono>
+
+/* Shortest of [repeats] runs of [run], in seconds; the shortest is the one the rest of the machine disturbed least */
+template<typename Function>
+double bestOf(int repeats, Function &&run) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+#endif //OPENGL_TIMING_H
@@ -0,0 +1,29 @@
+#ifndef OPENGL_CHECK_H
+#define OPENGL_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+/* Failed CHECKs so far; a check program keeps going after one so a run reports all of them */
+inline int s_CheckFailures = 0;
+
+inline void check(bool condition, const char *what, const char *file, int line) {
+    if (!condition) {
+        fprintf(stderr, "FAIL %s:%d: %s\n", file, line, what);
+        s_CheckFailures++;
+    }
+}
+
+#define CHECK(x) check((x), #x, __FILE_NAME__, __LINE__)
+
+/* Prints the outcome; returns main()'s exit code */
+inline int checkResult(const char *name) {
+    if (s_CheckFailures) {
+        fprintf(stderr, "%d %s checks failed\n", s_CheckFailures, name);
+        return EXIT_FAILURE;
+    }
+    printf("%s checks passed\n", name);
+    return EXIT_SUCCESS;
+}
+
+#endif //OPENGL_CHECK_H
@@ -0,0 +1,84 @@
+#define GLAD_GL_IMPLEMENTATION
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstdio>
+#include <cstring>
+#include "Headless.h"
+#include "Renderer.h"
+#include "GLExtensions.h"
+
+static EGLDisplay s_Display = EGL_NO_DISPLAY;
+static EGLSurface s_Surface = EGL_NO_SURFACE;
+static EGLContext s_Context = EGL_NO_CONTEXT;
+
+static GLADapiproc loadProc(const char *name) {
+    return (GLADapiproc) eglGetProcAddress(name);
+}
+
+/* Mesa's surfaceless platform needs neither X nor a GPU; elsewhere the default display has to do */
+static EGLDisplay openDisplay() {
+    const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+bool createHeadlessContext(int major, int minor, int width, int height, bool debug) {
+    s_Display = openDisplay();
+    if (s_Display == EGL_NO_DISPLAY || !eglInitialize(s_Display, nullptr, nullptr)) {
+        fprintf(stderr, "Error: no EGL display\n");
+        return false;
+    }
+
+    const EGLint configAttributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                       EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24,
+                                       EGL_NONE};
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(s_Display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        fprintf(stderr, "Error: no EGL config with an OpenGL pbuffer\n");
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    s_Surface = eglCreatePbufferSurface(s_Display, config, surfaceAttributes);
+
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttributes[] = {EGL_CONTEXT_MAJOR_VERSION, major, EGL_CONTEXT_MINOR_VERSION, minor,
+                                        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                        EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE, EGL_NONE};
+    s_Context = eglCreateContext(s_Display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (s_Surface == EGL_NO_SURFACE || s_Context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(s_Display, s_Surface, s_Surface, s_Context)) {
+        fprintf(stderr, "Error: couldn't create an OpenGL %d.%d core context\n", major, minor);
+        return false;
+    }
+
+    if (!gladLoadGL(loadProc)) {
+        fprintf(stderr, "Error: couldn't load OpenGL\n");
+        return false;
+    }
+    loadGLExtensions(loadProc);
+    return true;
+}
+
+void destroyHeadlessContext() {
+    if (s_Display == EGL_NO_DISPLAY)
+        return;
+    eglMakeCurrent(s_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (s_Context != EGL_NO_CONTEXT)
+        eglDestroyContext(s_Display, s_Context);
+    if (s_Surface != EGL_NO_SURFACE)
+        eglDestroySurface(s_Display, s_Surface);
+    eglTerminate(s_Display);
+    s_Display = EGL_NO_DISPLAY;
+    s_Surface = EGL_NO_SURFACE;
+    s_Context = EGL_NO_CONTEXT;
+}
@@ -0,0 +1,10 @@
+#ifndef OPENGL_HEADLESS_H
+#define OPENGL_HEADLESS_H
+
+/* An offscreen core profile context through EGL, for the checks and benchmarks, which run without a display
+ * (Mesa's llvmpipe on a build machine, say). The default framebuffer is a [width] x [height] pbuffer.
+ * Loads glad and the extensions into it; prints why and returns false when no such context can be made */
+bool createHeadlessContext(int major, int minor, int width = 256, int height = 256, bool debug = false);
+void destroyHeadlessContext();
+
+#endif //OPENGL_HEADLESS_H
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "LinmathSIMD.h"
+#include "ThreadPool.h"
+#include "TransformBatch.h"
+
+/* CPU-only: the simd:: functions against linmath's scalar ones, including outputs aliasing an input, on
+ * whichever implementation this machine selects; and TransformBatch's kernel against the scalar call chain */
+
+static constexpr size_t COUNT = 257; /* Not a multiple of any vector width */
+static constexpr float TOLERANCE = 1e-4f;
+
+static bool nearlyEqual(const float *a, const float *b, int count, float tolerance = TOLERANCE) {
+    for (int i = 0; i < count; i++) {
+        if (std::abs(a[i] - b[i]) > tolerance * std::max(1.f, std::abs(b[i])))
+            return false;
+    }
+    return true;
+}
+
+static bool nearlyEqual(mat4x4 const a, mat4x4 const b, float tolerance = TOLERANCE) {
+    return nearlyEqual(&a[0][0], &b[0][0], 16, tolerance);
+}
+
+struct Inputs {
+    std::vector<mat4x4> matrices = std::vector<mat4x4>(COUNT);
+    std::vector<vec4> vectors = std::vector<vec4>(COUNT);
+    std::vector<quat> quaternions = std::vector<quat>(COUNT);
+
+    Inputs() {
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+        for (size_t i = 0; i < COUNT; i++) {
+            /* Diagonally dominant, so every matrix inverts */
+            for (int column = 0; column < 4; column++)
+                for (int row = 0; row < 4; row++)
+                    matrices[i][column][row] = uniform(random) + (column == row ? 4.f : 0.f);
+            for (int k = 0; k < 4; k++)
+                vectors[i][k] = uniform(random);
+            vec4_norm(quaternions[i], vectors[i]);
+        }
+    }
+};
+
+static void checkSingle(const Inputs &inputs) {
+    bool mul = true, mulAliased = true, mulVec = true, invert = true, invertAliased = true, quatMul = true,
+        fromQuat = true;
+    for (size_t i = 0; i + 1 < COUNT; i++) {
+        const mat4x4 &a = inputs.matrices[i], &b = inputs.matrices[i + 1];
+        mat4x4 expected, result;
+        mat4x4_mul(expected, a, b);
+        simd::mat4x4_mul(result, a, b);
+        mul &= nearlyEqual(result, expected);
+        mat4x4_dup(result, a);
+        simd::mat4x4_mul(result, result, b);
+        mulAliased &= nearlyEqual(result, expected);
+
+        vec4 expectedVector, vector;
+        mat4x4_mul_vec4(expectedVector, a, inputs.vectors[i]);
+        simd::mat4x4_mul_vec4(vector, a, inputs.vectors[i]);
+        mulVec &= nearlyEqual(vector, expectedVector, 4);
+
+        mat4x4_invert(expected, a);
+        simd::mat4x4_invert(result, a);
+        invert &= nearlyEqual(result, expected);
+        mat4x4_dup(result, a);
+        simd::mat4x4_invert(result, result);
+        invertAliased &= nearlyEqual(result, expected);
+
+        quat expectedQuat, product;
+        quat_mul(expectedQuat, inputs.quaternions[i], inputs.quaternions[i + 1]);
+        simd::quat_mul(product, inputs.quaternions[i], inputs.quaternions[i + 1]);
+        quatMul &= nearlyEqual(product, expectedQuat, 4);
+
+        mat4x4_from_quat(expected, inputs.quaternions[i]);
+        simd::mat4x4_from_quat(result, inputs.quaternions[i]);
+        fromQuat &= nearlyEqual(result, expected);
+    }
+    CHECK(mul);
+    CHECK(mulAliased);
+    CHECK(mulVec);
+    CHECK(invert);
+    CHECK(invertAliased);
+    CHECK(quatMul);
+    CHECK(fromQuat);
+}
+
+/* Every length up to a few vector widths, so the remainder loops run too */
+static void checkArray(const Inputs &inputs) {
+    const mat4x4 &a = inputs.matrices[0];
+    std::vector<mat4x4> results(COUNT);
+    bool matches = true, untouched = true;
+    for (size_t count = 0; count <= 17; count++) {
+        for (mat4x4 &result: results)
+            mat4x4_identity(result);
+        simd::mat4x4_mul_array(results.data(), a, inputs.matrices.data() + 1, count);
+        for (size_t i = 0; i < count; i++) {
+            mat4x4 expected;
+            mat4x4_mul(expected, a, inputs.matrices[i + 1]);
+            matches &= nearlyEqual(results[i], expected);
+        }
+        untouched &= results[count][0][0] == 1.f && results[count][3][3] == 1.f && results[count][0][1] == 0.f;
+    }
+    CHECK(matches);
+    CHECK(untouched);
+
+    /* In place, b aliasing M */
+    std::vector<mat4x4> inPlace(COUNT);
+    std::memcpy(inPlace.data(), inputs.matrices.data(), COUNT * sizeof(mat4x4));
+    simd::mat4x4_mul_array(inPlace.data(), a, inPlace.data(), COUNT);
+    bool inPlaceMatches = true;
+    for (size_t i = 0; i < COUNT; i++) {
+        mat4x4 expected;
+        mat4x4_mul(expected, a, inputs.matrices[i]);
+        inPlaceMatches &= nearlyEqual(inPlace[i], expected);
+    }
+    CHECK(inPlaceMatches);
+}
+
+/* Enough objects for the pool to split them into several chunks; the last few are left as resize() made them,
+ * so their models are identities */
+static void checkTransformBatch(const Inputs &inputs) {
+    static constexpr size_t SET = 3000, DEFAULTED = 3;
+    std::mt19937 random(13);
+    std::uniform_real_distribution<float> uniform(-2.f, 2.f);
+    TransformBatch batch;
+    batch.resize(SET + DEFAULTED);
+    std::vector<mat4x4> expectedModels(SET + DEFAULTED), expectedMVPs(SET + DEFAULTED);
+    const mat4x4 &viewProjection = inputs.matrices[0];
+    for (size_t i = 0; i < SET + DEFAULTED; i++) {
+        mat4x4 &model = expectedModels[i];
+        const quat &orientation = inputs.quaternions[i % COUNT];
+        if (i < SET) {
+            vec3 position = {uniform(random), uniform(random), uniform(random)};
+            vec3 scale = {uniform(random), uniform(random), uniform(random)};
+            batch.set(i, position, orientation, scale);
+
+            mat4x4 rotation;
+            mat4x4_translate(model, position[0], position[1], position[2]);
+            mat4x4_from_quat(rotation, orientation);
+            mat4x4_mul(model, model, rotation);
+            mat4x4_scale_aniso(model, model, scale[0], scale[1], scale[2]);
+        } else {
+            mat4x4_identity(model);
+        }
+        mat4x4_mul(expectedMVPs[i], viewProjection, model);
+    }
+
+    ThreadPool pool(4);
+    for (ThreadPool *threads: {(ThreadPool *) nullptr, &pool}) {
+        std::vector<mat4x4> models(SET + DEFAULTED), mvps(SET + DEFAULTED), mvpsOnly(SET + DEFAULTED);
+        computeTransforms(batch, viewProjection, models.data(), mvps.data(), threads);
+        computeTransforms(batch, viewProjection, nullptr, mvpsOnly.data(), threads);
+        bool modelsMatch = true, mvpsMatch = true, mvpsOnlyMatch = true;
+        for (size_t i = 0; i < SET + DEFAULTED; i++) {
+            modelsMatch &= nearlyEqual(models[i], expectedModels[i]);
+            mvpsMatch &= nearlyEqual(mvps[i], expectedMVPs[i]);
+            mvpsOnlyMatch &= nearlyEqual(mvpsOnly[i], expectedMVPs[i]);
+        }
+        CHECK(modelsMatch);
+        CHECK(mvpsMatch);
+        CHECK(mvpsOnlyMatch);
+    }
+}
+
+int main() {
+    printf("Matrix math: %s\n", simd::getImplementation());
+    Inputs inputs;
+    checkSingle(inputs);
+    checkArray(inputs);
+    checkTransformBatch(inputs);
+    return checkResult("Matrix");
+}
@@ -0,0 +1,148 @@
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include "Check.h"
+#include "MeshFile.h"
+#include "VertexPacking.h"
+
+/* CPU-only round trips through writeMeshFile() and MeshFile, and files MeshFile must refuse */
+
+struct Vertex {
+    float position[3];
+    int2_10_10_10 normal;
+    half uv[2];
+};
+
+static VertexBufferLayout makeLayout() {
+    VertexBufferLayout layout;
+    layout.Push<float>(3, 0);
+    layout.Push<int2_10_10_10>(1, 1);
+    layout.Push<half>(2, 2);
+    return layout;
+}
+
+static std::vector<Vertex> makeVertices(unsigned int count) {
+    std::vector<Vertex> vertices(count);
+    for (unsigned int i = 0; i < count; i++) {
+        vertices[i] = {{(float) i, 0.5f * (float) i, -(float) i}, {i * 2654435761u},
+                       {{(uint16_t) i}, {(uint16_t) (i >> 16)}}};
+    }
+    return vertices;
+}
+
+static bool sameLayout(const VertexBufferLayout &a, const VertexBufferLayout &b) {
+    if (a.getStride() != b.getStride() || a.GetElement().size() != b.GetElement().size())
+        return false;
+    for (size_t i = 0; i < a.GetElement().size(); i++) {
+        const VertexBufferElement &x = a.GetElement()[i], &y = b.GetElement()[i];
+        if (x.type != y.type || x.count != y.count || x.normalised != y.normalised || x.location != y.location ||
+            x.divisor != y.divisor || x.offset != y.offset)
+            return false;
+    }
+    return true;
+}
+
+/* Writes, reloads and compares; indices past 65535 must keep the file at 32-bit indices */
+static void checkRoundTrip(const std::filesystem::path &path, unsigned int vertexCount,
+                           const std::vector<MeshRange> &meshes, unsigned int expectedIndexType) {
+    VertexBufferLayout layout = makeLayout();
+    std::vector<Vertex> vertices = makeVertices(vertexCount);
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i + 2 < vertexCount; i += 3)
+        indices.insert(indices.end(), {i + 2, i, i + 1});
+
+    CHECK(writeMeshFile(path, layout, vertices.data(), vertexCount, indices.data(), (unsigned int) indices.size(),
+                        meshes));
+    MeshFile file(path);
+    CHECK(file.isValid());
+    if (!file.isValid())
+        return;
+
+    CHECK(sameLayout(file.getLayout(), layout));
+    CHECK(file.getVertexCount() == vertexCount);
+    CHECK(file.getVertexDataSize() == vertexCount * sizeof(Vertex));
+    CHECK(std::memcmp(file.getVertexData(), vertices.data(), vertexCount * sizeof(Vertex)) == 0);
+    CHECK((uintptr_t) file.getVertexData() % MESH_FILE_ALIGNMENT == 0);
+    CHECK((uintptr_t) file.getIndexData() % MESH_FILE_ALIGNMENT == 0);
+
+    CHECK(file.getIndexType() == expectedIndexType);
+    CHECK(file.getIndexCount() == indices.size());
+    bool indicesMatch = true;
+    for (size_t i = 0; i < indices.size(); i++) {
+        unsigned int index = expectedIndexType == GL_UNSIGNED_SHORT ?
+                             ((const uint16_t *) file.getIndexData())[i] :
+                             ((const uint32_t *) file.getIndexData())[i];
+        indicesMatch &= index == indices[i];
+    }
+    CHECK(indicesMatch);
+
+    std::vector<MeshRange> expected = meshes;
+    if (expected.empty())
+        expected.push_back({0, vertexCount, 0, (unsigned int) indices.size()});
+    std::span<const MeshRange> loaded = file.getMeshes();
+    CHECK(loaded.size() == expected.size() &&
+          std::memcmp(loaded.data(), expected.data(), expected.size() * sizeof(MeshRange)) == 0);
+}
+
+/* Patches [size] bytes at [offset] of a good file, which must then be rejected */
+static bool rejectsPatched(const std::filesystem::path &good, const std::filesystem::path &path, uint64_t offset,
+                           const void *data, size_t size) {
+    std::filesystem::copy_file(good, path, std::filesystem::copy_options::overwrite_existing);
+    {
+        std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+        stream.seekp((std::streamoff) offset);
+        stream.write((const char *) data, (std::streamsize) size);
+    }
+    return !MeshFile(path).isValid();
+}
+
+static void checkRejected(const std::filesystem::path &good, const std::filesystem::path &path) {
+    MeshFileHeader header{};
+    {
+        std::ifstream stream(good, std::ios::binary);
+        stream.read((char *) &header, sizeof(header));
+    }
+    uint64_t size = std::filesystem::file_size(good);
+
+    /* Cut off before the last index */
+    std::filesystem::copy_file(good, path, std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(path, size - 1);
+    CHECK(!MeshFile(path).isValid());
+    std::filesystem::resize_file(path, sizeof(MeshFileHeader) - 1);
+    CHECK(!MeshFile(path).isValid());
+    CHECK(!MeshFile(path.string() + ".missing").isValid());
+
+    const char magic[4] = {'O', 'B', 'J', ' '};
+    CHECK(rejectsPatched(good, path, offsetof(MeshFileHeader, magic), magic, sizeof(magic)));
+    const uint32_t version = MESH_FILE_VERSION + 1;
+    CHECK(rejectsPatched(good, path, offsetof(MeshFileHeader, version), &version, sizeof(version)));
+    const uint32_t vertexCount = header.vertexCount * 4;
+    CHECK(rejectsPatched(good, path, offsetof(MeshFileHeader, vertexCount), &vertexCount, sizeof(vertexCount)));
+    const uint64_t indexOffset = header.indexOffset + 1;
+    CHECK(rejectsPatched(good, path, offsetof(MeshFileHeader, indexOffset), &indexOffset, sizeof(indexOffset)));
+    const uint32_t attributeOffset = header.vertexStride;
+    CHECK(rejectsPatched(good, path, sizeof(MeshFileHeader) + offsetof(MeshFileAttribute, offset),
+                         &attributeOffset, sizeof(attributeOffset)));
+    const MeshRange range = {0, header.vertexCount, header.indexCount, 3};
+    CHECK(rejectsPatched(good, path, sizeof(MeshFileHeader) + header.attributeCount * sizeof(MeshFileAttribute),
+                         &range, sizeof(range)));
+}
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "MeshFileCheck";
+    std::filesystem::create_directories(directory);
+    std::filesystem::path path = directory / "mesh.oglm";
+
+    checkRoundTrip(path, 300, {}, GL_UNSIGNED_SHORT);
+    checkRoundTrip(path, 300, {{0, 150, 0, 150}, {150, 150, 150, 150}}, GL_UNSIGNED_SHORT);
+    checkRoundTrip(path, 70000, {}, GL_UNSIGNED_INT);
+
+    /* A small file again to corrupt */
+    checkRoundTrip(path, 300, {}, GL_UNSIGNED_SHORT);
+    checkRejected(path, directory / "broken.oglm");
+
+    std::filesystem::remove_all(directory);
+    return checkResult("Mesh file");
+}
@@ -0,0 +1,144 @@
+#include <cmath>
+#include <vector>
+#include "Check.h"
+#include "MeshLOD.h"
+#include "MeshSimplifier.h"
+
+/* CPU-only checks of the simplifier and the LOD chain and selector built on it */
+
+struct Mesh {
+    std::vector<float> positions; /* xyz */
+    std::vector<unsigned int> indices;
+
+    size_t vertexCount() const { return positions.size() / 3; }
+};
+
+/* Unit sphere of [rings] x [segments] quads with shared vertices and single vertices at the poles, so it is
+ * closed and every vertex may move */
+static Mesh makeSphere(unsigned int rings, unsigned int segments) {
+    Mesh mesh;
+    mesh.positions = {0.f, 1.f, 0.f};
+    for (unsigned int ring = 1; ring < rings; ring++) {
+        float theta = (float) M_PI * (float) ring / (float) rings;
+        for (unsigned int segment = 0; segment < segments; segment++) {
+            float phi = 2.f * (float) M_PI * (float) segment / (float) segments;
+            mesh.positions.insert(mesh.positions.end(),
+                                  {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+        }
+    }
+    mesh.positions.insert(mesh.positions.end(), {0.f, -1.f, 0.f});
+
+    auto vertex = [&](unsigned int ring, unsigned int segment) {
+        if (ring == 0)
+            return 0u;
+        if (ring == rings)
+            return (unsigned int) mesh.vertexCount() - 1;
+        return 1 + (ring - 1) * segments + segment % segments;
+    };
+    for (unsigned int ring = 0; ring < rings; ring++) {
+        for (unsigned int segment = 0; segment < segments; segment++) {
+            unsigned int a = vertex(ring, segment), b = vertex(ring, segment + 1);
+            unsigned int c = vertex(ring + 1, segment + 1), d = vertex(ring + 1, segment);
+            if (ring != 0)
+                mesh.indices.insert(mesh.indices.end(), {a, b, c});
+            if (ring != rings - 1)
+                mesh.indices.insert(mesh.indices.end(), {a, c, d});
+        }
+    }
+    return mesh;
+}
+
+/* [n] x [n] quads in the z = 0 plane */
+static Mesh makePlane(unsigned int n) {
+    Mesh mesh;
+    for (unsigned int y = 0; y <= n; y++)
+        for (unsigned int x = 0; x <= n; x++)
+            mesh.positions.insert(mesh.positions.end(), {(float) x, (float) y, 0.f});
+    for (unsigned int y = 0; y < n; y++) {
+        for (unsigned int x = 0; x < n; x++) {
+            unsigned int a = y * (n + 1) + x, b = a + 1, c = a + n + 2, d = a + n + 1;
+            mesh.indices.insert(mesh.indices.end(), {a, b, c, a, c, d});
+        }
+    }
+    return mesh;
+}
+
+static void checkSimplifier() {
+    Mesh sphere = makeSphere(32, 64);
+    size_t target = sphere.indices.size() / 4 / 3 * 3;
+    std::vector<unsigned int> simplified(sphere.indices.size());
+    float error = -1.f;
+    size_t count = simplifyMesh(simplified.data(), sphere.indices.data(), sphere.indices.size(),
+                                sphere.positions.data(), sphere.vertexCount(), 3 * sizeof(float), target, INFINITY,
+                                &error);
+    CHECK(count <= target);
+    CHECK(count >= target * 9 / 10);
+    CHECK(count % 3 == 0);
+    CHECK(error > 0.f && error < 0.1f);
+    bool degenerate = false;
+    for (size_t i = 0; i < count; i += 3)
+        degenerate |= simplified[i] == simplified[i + 1] || simplified[i + 1] == simplified[i + 2] ||
+                      simplified[i] == simplified[i + 2];
+    CHECK(!degenerate);
+
+    /* Nothing may collapse when every collapse costs more than [maxError] */
+    count = simplifyMesh(simplified.data(), sphere.indices.data(), sphere.indices.size(), sphere.positions.data(),
+                         sphere.vertexCount(), 3 * sizeof(float), target, 1e-7f, &error);
+    CHECK(count == sphere.indices.size());
+
+    /* A flat interior collapses at no cost; its border vertices stay */
+    Mesh plane = makePlane(16);
+    simplified.resize(plane.indices.size());
+    count = simplifyMesh(simplified.data(), plane.indices.data(), plane.indices.size(), plane.positions.data(),
+                         plane.vertexCount(), 3 * sizeof(float), 0, INFINITY, &error);
+    CHECK(count < plane.indices.size() / 4);
+    CHECK(error < 1e-3f);
+}
+
+static void checkChain() {
+    Mesh sphere = makeSphere(32, 64);
+    LODChain chain = generateLODs(sphere.positions.data(), sphere.vertexCount(), 3 * sizeof(float),
+                                  sphere.indices.data(), sphere.indices.size(), 5, 0.5f);
+    CHECK(chain.levels.size() == 5);
+    CHECK(chain.levels[0].indexCount == sphere.indices.size() && chain.levels[0].error == 0.f);
+    for (size_t level = 1; level < chain.levels.size(); level++) {
+        const LODLevel &previous = chain.levels[level - 1], &current = chain.levels[level];
+        CHECK(current.indexCount <= previous.indexCount / 2 + 2);
+        CHECK(current.error >= previous.error);
+        CHECK(current.firstIndex == previous.firstIndex + previous.indexCount);
+    }
+    CHECK(chain.indices.size() == chain.levels.back().firstIndex + chain.levels.back().indexCount);
+    CHECK(std::abs(chain.bounds.radius - std::sqrt(3.f)) < 1e-3f);
+
+    /* Moving away only ever coarsens; coming back refines again */
+    LODSelector selector(1.f, 0.25f);
+    BoundingSphere bounds = chain.bounds;
+    unsigned int level = 0, previousLevel = 0;
+    bool monotonic = true;
+    for (float distance = 2.f; distance < 10000.f; distance *= 1.1f) {
+        vec3 eye = {0.f, 0.f, distance};
+        selector.setView(eye, 1.f, 1080);
+        level = selector.select(chain.levels, bounds, level);
+        monotonic &= level >= previousLevel;
+        previousLevel = level;
+    }
+    CHECK(monotonic);
+    CHECK(level == chain.levels.size() - 1);
+    vec3 near = {0.f, 0.f, 2.f};
+    selector.setView(near, 1.f, 1080);
+    CHECK(selector.select(chain.levels, bounds, level) == 0);
+
+    /* Just past where level 1 becomes acceptable, a new object stays at 0 but one already at 1 keeps it */
+    float error = chain.levels[1].error;
+    float pixelsPerUnit = 1080.f / (2.f * std::tan(0.5f));
+    vec3 switching = {0.f, 0.f, error * pixelsPerUnit / 0.9f + bounds.radius};
+    selector.setView(switching, 1.f, 1080);
+    CHECK(selector.select(chain.levels, bounds, 0) == 0);
+    CHECK(selector.select(chain.levels, bounds, 1) == 1);
+}
+
+int main() {
+    checkSimplifier();
+    checkChain();
+    return checkResult("Mesh LOD");
+}
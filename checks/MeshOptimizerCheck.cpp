@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "MeshOptimizer.h"
+
+/* CPU-only checks of the vertex cache model and the optimisation passes */
+
+/* The cache analyzeVertexCache() models, written the obvious way */
+static size_t fifoMisses(const std::vector<unsigned int> &indices, unsigned int cacheSize) {
+    std::deque<unsigned int> fifo;
+    size_t misses = 0;
+    for (unsigned int vertex: indices) {
+        if (std::find(fifo.begin(), fifo.end(), vertex) != fifo.end())
+            continue;
+        misses++;
+        fifo.push_back(vertex);
+        if (fifo.size() > cacheSize)
+            fifo.pop_front();
+    }
+    return misses;
+}
+
+static void checkCacheModel() {
+    /* 0, 1, 2 and 3 miss; with three entries 3 evicts 0, so it misses again. With four it stays */
+    std::vector<unsigned int> traced = {0, 1, 2, 3, 3, 3, 0, 0, 0};
+    CHECK(analyzeVertexCache(traced.data(), traced.size(), 4, 3).transformedVertices == 5);
+    CHECK(analyzeVertexCache(traced.data(), traced.size(), 4, 4).transformedVertices == 4);
+    CHECK(analyzeVertexCache(traced.data(), traced.size(), 4, 1).transformedVertices == 5);
+
+    std::mt19937 random(3);
+    for (unsigned int cacheSize = 1; cacheSize <= 24; cacheSize++) {
+        std::vector<unsigned int> indices(3000);
+        for (unsigned int &index: indices)
+            index = random() % 40;
+        CHECK(analyzeVertexCache(indices.data(), indices.size(), 40, cacheSize).transformedVertices ==
+              fifoMisses(indices, cacheSize));
+    }
+}
+
+struct GridVertex {
+    float position[3];
+};
+
+/* [n] x [n] quads with every triangle's vertices written out separately, triangles in random order */
+static void makeGrid(int n, std::vector<GridVertex> &vertices, std::vector<unsigned int> &indices) {
+    std::vector<std::array<GridVertex, 3>> triangles;
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            GridVertex a = {{(float) x, (float) y, 0.f}}, b = {{(float) x + 1, (float) y, 0.f}};
+            GridVertex c = {{(float) x + 1, (float) y + 1, 0.f}}, d = {{(float) x, (float) y + 1, 0.f}};
+            triangles.push_back({a, b, c});
+            triangles.push_back({a, c, d});
+        }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(9));
+    for (const auto &triangle: triangles) {
+        for (const GridVertex &vertex: triangle) {
+            indices.push_back((unsigned int) vertices.size());
+            vertices.push_back(vertex);
+        }
+    }
+}
+
+/* Each triangle as its corner positions, rotated to start at the smallest, sorted: equal for two index buffers
+ * drawing the same triangles with the same winding */
+static std::vector<std::array<float, 9>> triangleSet(const std::vector<GridVertex> &vertices,
+                                                     const unsigned int *indices, size_t indexCount) {
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t i = 0; i < indexCount; i += 3) {
+        std::array<std::array<float, 3>, 3> corners{};
+        for (int corner = 0; corner < 3; corner++)
+            for (int axis = 0; axis < 3; axis++)
+                corners[corner][axis] = vertices[indices[i + corner]].position[axis];
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+        std::array<float, 9> flat{};
+        for (int k = 0; k < 9; k++)
+            flat[k] = corners[k / 3][k % 3];
+        triangles.push_back(flat);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void checkOptimizeMesh() {
+    std::vector<GridVertex> vertices;
+    std::vector<unsigned int> indices;
+    makeGrid(32, vertices, indices);
+    auto before = triangleSet(vertices, indices.data(), indices.size());
+
+    size_t vertexCount = vertices.size();
+    MeshOptimizationReport report = optimizeMesh(vertices.data(), vertexCount, sizeof(GridVertex), 0,
+                                                 indices.data(), indices.size());
+    vertices.resize(vertexCount);
+    CHECK(report.verticesBefore == 32 * 32 * 6);
+    CHECK(report.verticesAfter == 33 * 33);
+    CHECK(vertexCount == 33 * 33);
+    CHECK(std::all_of(indices.begin(), indices.end(), [&](unsigned int index) { return index < vertexCount; }));
+    CHECK(triangleSet(vertices, indices.data(), indices.size()) == before);
+
+    /* Every vertex is transformed at least once, so 1089 / 2048 triangles is the floor */
+    CHECK(report.after.transformedVertices >= vertexCount);
+    CHECK(report.after.acmr < 0.8f);
+    CHECK(report.after.acmr < report.before.acmr);
+    CHECK(report.after.acmr == analyzeVertexCache(indices.data(), indices.size(), vertexCount).acmr);
+
+    /* Fetch order: vertices are first used in ascending order */
+    unsigned int nextNew = 0;
+    bool ascending = true;
+    for (unsigned int index: indices) {
+        if (index > nextNew)
+            ascending = false;
+        else if (index == nextNew)
+            nextNew++;
+    }
+    CHECK(ascending);
+}
+
+int main() {
+    checkCacheModel();
+    checkOptimizeMesh();
+    return checkResult("Mesh optimizer");
+}
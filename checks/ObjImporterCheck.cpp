@@ -0,0 +1,76 @@
+#include <string>
+#include "Check.h"
+#include "ObjImporter.h"
+#include "ThreadPool.h"
+
+/* CPU-only checks of OBJ parsing: index forms, relative indices, and indices that must be rejected */
+
+static void checkQuad() {
+    std::optional<ObjModel> model = parseObj("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                                             "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\n"
+                                             "usemtl a\nf 1/1/1 2/2/1 3/3/1 4/4/1\n");
+    CHECK(model.has_value());
+    if (!model)
+        return;
+    CHECK(model->vertices.size() == 4);
+    CHECK(model->indices.size() == 6);
+    CHECK(model->hasTexCoords && model->hasNormals);
+    CHECK(model->groups.size() == 1 && model->groups[0].material == "a" && model->groups[0].indexCount == 6);
+    CHECK(model->vertices[model->indices[2]].texCoord[0] == 1.f && model->vertices[model->indices[2]].texCoord[1] == 1.f);
+}
+
+static void checkRelativeIndices() {
+    /* The same triangle written with negative indices, after an unrelated one */
+    std::optional<ObjModel> model = parseObj("v 5 5 5\nv 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\n"
+                                             "f -3//-1 -2//-1 -1//-1\n");
+    CHECK(model.has_value());
+    if (!model)
+        return;
+    CHECK(model->indices.size() == 3 && !model->hasTexCoords && model->hasNormals);
+    CHECK(model->vertices[model->indices[0]].position[0] == 0.f);
+    CHECK(model->vertices[model->indices[1]].position[0] == 1.f);
+}
+
+static void checkRejected() {
+    /* vt -2 with one vt read lands before the first, which must not pass for "no texture coordinate" */
+    CHECK(!parseObj("v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nf 1/-2 2/1 3/1\n"));
+    CHECK(!parseObj("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//-2 2//1 3//1\n"));
+    CHECK(!parseObj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -4 2 3\n"));
+    CHECK(!parseObj("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n"));
+    CHECK(!parseObj("v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nf 1/2 2/1 3/1\n"));
+}
+
+/* Several chunks, with relative indices reaching back into the chunk before; a pool must give the same model */
+static void checkChunks() {
+    std::string text;
+    int quads = 100000;
+    for (int i = 0; i < quads; i++) {
+        text += "v " + std::to_string(i) + " 0 0\nv " + std::to_string(i) + " 1 0\n";
+        if (i > 0)
+            text += "f -4 -3 -1 -2\n";
+    }
+    ThreadPool pool(2);
+    std::optional<ObjModel> serial = parseObj(text), pooled = parseObj(text, &pool);
+    CHECK(text.size() > (2u << 20));
+    CHECK(serial && pooled);
+    if (!serial || !pooled)
+        return;
+    CHECK(serial->indices.size() == (size_t) (quads - 1) * 6);
+    CHECK(serial->vertices.size() == (size_t) quads * 2);
+    CHECK(serial->indices == pooled->indices);
+    bool adjacent = true;
+    for (size_t i = 0; i < serial->indices.size(); i += 6) {
+        float x0 = serial->vertices[serial->indices[i]].position[0];
+        float x1 = serial->vertices[serial->indices[i + 1]].position[0];
+        adjacent &= x1 == x0 && serial->vertices[serial->indices[i + 2]].position[0] == x0 + 1.f;
+    }
+    CHECK(adjacent);
+}
+
+int main() {
+    checkQuad();
+    checkRelativeIndices();
+    checkRejected();
+    checkChunks();
+    return checkResult("OBJ importer");
+}
@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "Headless.h"
+#include "GeometryArena.h"
+#include "GLState.h"
+#include "OcclusionCuller.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "VertexBufferLayout.h"
+
+/* Checks OcclusionCuller against a single occluder, a quad at z = -5 spanning [-2, 2] on x and y, seen through a
+ * perspective camera at the origin. Exits non-zero on any failure */
+
+static const char *OCCLUDER_VERTEX = R"(#version 330
+layout(location = 0) in vec3 vPos;
+uniform mat4 u_MVP;
+void main()
+{
+    gl_Position = u_MVP * vec4(vPos, 1.0);
+}
+)";
+
+static const char *OCCLUDER_FRAGMENT = R"(#version 330
+out vec4 color;
+void main()
+{
+    color = vec4(1.0);
+}
+)";
+
+struct Scene {
+    Shader shader{ShaderProgramSource{OCCLUDER_VERTEX, OCCLUDER_FRAGMENT}, "Occluder"};
+    GeometryArena arena;
+    MeshRange quad{};
+    mat4x4 viewProjection;
+
+    explicit Scene(const VertexBufferLayout &layout) : arena(layout, 64, 64) {
+        float vertices[] = {-2.f, -2.f, -5.f, 2.f, -2.f, -5.f, 2.f, 2.f, -5.f, -2.f, 2.f, -5.f};
+        unsigned int indices[] = {0, 1, 2, 0, 2, 3};
+        quad = *arena.allocate(vertices, 4, indices, 6);
+        mat4x4 projection;
+        mat4x4_perspective(projection, 1.2f, 1.f, 0.5f, 100.f);
+        mat4x4_dup(viewProjection, projection);
+    }
+
+    void drawOccluders(OcclusionCuller &culler) {
+        culler.beginOccluders(viewProjection);
+        shader.bind();
+        shader.setUniformMat4x4("u_MVP", viewProjection);
+        Renderer renderer;
+        renderer.draw(arena, quad, shader);
+        culler.endOccluders();
+    }
+};
+
+/* Readbacks arrive a frame late, so a few frames with the GPU finished in between always leave a chain */
+static void settle(Scene &scene, OcclusionCuller &culler, int frames) {
+    for (int frame = 0; frame < frames; frame++) {
+        scene.drawOccluders(culler);
+        GLCall(glFinish());
+    }
+    culler.collectReadbacks();
+}
+
+/* Every level must hold the farthest depth of the texels under it, the last row and column of odd-sized
+ * levels included */
+static void checkChain(const OcclusionCuller &culler) {
+    std::vector<std::vector<float>> levels;
+    std::vector<std::pair<int, int>> sizes;
+    GLCall(glBindTexture(GL_TEXTURE_2D, culler.getDepthTexture()));
+    for (int width = culler.getWidth(), height = culler.getHeight(), level = 0;; level++) {
+        levels.emplace_back((size_t) width * height);
+        sizes.emplace_back(width, height);
+        GLCall(glGetTexImage(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT, GL_FLOAT, levels.back().data()));
+        if (width == 1 && height == 1)
+            break;
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+
+    int mismatches = 0;
+    for (size_t level = 1; level < levels.size(); level++) {
+        auto [aboveWidth, aboveHeight] = sizes[level - 1];
+        auto [width, height] = sizes[level];
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int lastX = x == width - 1 ? aboveWidth - 1 : 2 * x + 1;
+                int lastY = y == height - 1 ? aboveHeight - 1 : 2 * y + 1;
+                float farthest = 0.f;
+                for (int aboveY = 2 * y; aboveY <= lastY; aboveY++)
+                    for (int aboveX = 2 * x; aboveX <= lastX; aboveX++)
+                        farthest = std::max(farthest, levels[level - 1][(size_t) aboveY * aboveWidth + aboveX]);
+                mismatches += farthest != levels[level][(size_t) y * width + x];
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void checkBounds(Scene &scene) {
+    const std::pair<int, int> sizes[] = {{128, 128}, {157, 93}, {1, 1}, {64, 7}, {96, 64}};
+    for (auto [width, height]: sizes) {
+        OcclusionCuller culler(width, height);
+        AABB behind = {{-0.5f, -0.5f, -11.f}, {0.5f, 0.5f, -10.f}};
+
+        scene.drawOccluders(culler);
+        CHECK(!culler.hasDepth() && !culler.isOccluded(behind));
+        GLCall(glFinish());
+        settle(scene, culler, 2);
+        CHECK(culler.hasDepth());
+
+        /* Too coarse a culler shrinks the occluder to nothing, or tests the box on a level whose texels reach
+         * past it, which are both the safe direction */
+        bool resolves = std::min(width, height) >= 64;
+        CHECK(culler.isOccluded(behind) == resolves);
+        CHECK(!culler.isOccluded(AABB{{-0.5f, -0.5f, -4.f}, {0.5f, 0.5f, -3.f}}));   /* In front */
+        CHECK(!culler.isOccluded(AABB{{8.f, -0.5f, -20.f}, {9.f, 0.5f, -19.f}}));    /* Beside */
+        CHECK(!culler.isOccluded(AABB{{1.5f, -0.5f, -11.f}, {3.5f, 0.5f, -10.f}}));  /* Past its edge */
+        CHECK(!culler.isOccluded(AABB{{-2.f, -2.f, -5.f}, {2.f, 2.f, -5.f}}));       /* Its own bounds */
+        CHECK(!culler.isOccluded(AABB{{-0.5f, -0.5f, -11.f}, {0.5f, 0.5f, 1.f}}));   /* Through the near plane */
+        CHECK(!culler.isOccluded(AABB{{30.f, 0.f, -11.f}, {31.f, 1.f, -10.f}}));     /* Outside the view */
+        checkChain(culler);
+    }
+}
+
+/* Random spheres: whatever the culler hides must lie wholly behind the quad, and the renderer must skip exactly
+ * what the culler and its frustum reject */
+static void checkRenderer(Scene &scene) {
+    OcclusionCuller culler(160, 160);
+    settle(scene, culler, 2);
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::vector<BoundingSphere> spheres(2000);
+    for (BoundingSphere &sphere: spheres) {
+        sphere = {{uniform(random) * 6.f, uniform(random) * 6.f, uniform(random) * 5.f - 11.f},
+                  0.05f + 0.3f * (uniform(random) + 1.f)};
+    }
+
+    Frustum frustum(scene.viewProjection);
+    Renderer renderer;
+    renderer.setCullFrustum(&frustum);
+    renderer.setOcclusionCuller(&culler);
+    for (const BoundingSphere &sphere: spheres)
+        renderer.submit(scene.arena, scene.quad, scene.shader, 0, 0.f, &sphere);
+    renderer.flush();
+
+    std::vector<uint32_t> inFrustum(spheres.size());
+    size_t inFrustumCount = frustum.cull(spheres.data(), spheres.size(), inFrustum.data());
+    unsigned int occluded = 0, wronglyOccluded = 0;
+    for (size_t i = 0; i < inFrustumCount; i++) {
+        const BoundingSphere &sphere = spheres[inFrustum[i]];
+        if (!culler.isOccluded(sphere))
+            continue;
+        occluded++;
+        for (int corner = 0; corner < 8; corner++) {
+            float r = sphere.radius;
+            float x = sphere.center[0] + (corner & 1 ? r : -r);
+            float y = sphere.center[1] + (corner & 2 ? r : -r);
+            float z = sphere.center[2] + (corner & 4 ? r : -r);
+            float scale = -5.f / z;
+            if (z > -5.f || std::abs(x * scale) > 2.05f || std::abs(y * scale) > 2.05f) {
+                wronglyOccluded++;
+                break;
+            }
+        }
+    }
+    CHECK(occluded > 0);
+    CHECK(wronglyOccluded == 0);
+    CHECK(renderer.getOccludedCount() == occluded);
+    CHECK(renderer.getCulledCount() == spheres.size() - inFrustumCount + occluded);
+}
+
+/* The occluder pass must leave the caller's framebuffers, viewport, depth state and textures as they were */
+static void checkStateRestored(Scene &scene) {
+    unsigned int renderbuffer, framebuffer;
+    GLCall(glGenRenderbuffers(1, &renderbuffer));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 64, 64));
+    GLCall(glGenFramebuffers(1, &framebuffer));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+
+    GLState::get().viewport(3, 5, 40, 30);
+    GLCall(glDisable(GL_DEPTH_TEST));
+    GLCall(glDepthFunc(GL_GEQUAL));
+    GLCall(glDepthMask(GL_FALSE));
+
+    /* Unit 2 is active, so both the constructor and the chain build, which samples from unit 0, touch them */
+    unsigned int textures[2];
+    GLCall(glGenTextures(2, textures));
+    GLCall(glBindTexture(GL_TEXTURE_2D, textures[0]));
+    GLCall(glActiveTexture(GL_TEXTURE2));
+    GLCall(glBindTexture(GL_TEXTURE_2D, textures[1]));
+
+    OcclusionCuller culler(64, 64);
+    scene.drawOccluders(culler);
+
+    int drawFramebuffer, readFramebuffer, depthFunc, viewport[4];
+    GLboolean depthMask;
+    GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer));
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer));
+    GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+    GLCall(glGetIntegerv(GL_DEPTH_FUNC, &depthFunc));
+    GLCall(glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask));
+    GLCall(bool depthTest = glIsEnabled(GL_DEPTH_TEST));
+    CHECK(drawFramebuffer == (int) framebuffer);
+    CHECK(readFramebuffer == 0);
+    CHECK(viewport[0] == 3 && viewport[1] == 5 && viewport[2] == 40 && viewport[3] == 30);
+    CHECK(depthFunc == GL_GEQUAL);
+    CHECK(depthMask == GL_FALSE);
+    CHECK(!depthTest);
+
+    int activeTexture, texture2, texture0;
+    GLCall(glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture));
+    GLCall(glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture2));
+    GLCall(glActiveTexture(GL_TEXTURE0));
+    GLCall(glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture0));
+    CHECK(activeTexture == GL_TEXTURE2);
+    CHECK(texture2 == (int) textures[1]);
+    CHECK(texture0 == (int) textures[0]);
+
+    GLCall(glDeleteTextures(2, textures));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GLCall(glDeleteFramebuffers(1, &framebuffer));
+    GLCall(glDeleteRenderbuffers(1, &renderbuffer));
+    GLCall(glDepthMask(GL_TRUE));
+    GLCall(glDepthFunc(GL_LESS));
+}
+
+int main() {
+    if (!createHeadlessContext(3, 3))
+        return EXIT_FAILURE;
+    {
+        VertexBufferLayout layout;
+        layout.Push<float>(3, 0);
+        Scene scene(layout);
+        checkBounds(scene);
+        checkRenderer(scene);
+        checkStateRestored(scene);
+        GLCall(GLenum error = glGetError());
+        CHECK(error == GL_NO_ERROR);
+    }
+    destroyHeadlessContext();
+    return checkResult("Occlusion");
+}
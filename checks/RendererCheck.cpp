@@ -0,0 +1,221 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "Check.h"
+#include "GeometryArena.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "Headless.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+/* Queued draws through Renderer::submit() and flush(), on whichever of the indirect and multi-draw paths the
+ * context offers, and again with the indirect one switched off; queued draws with their own transforms; and
+ * instanced draws stepping a per-instance attribute */
+
+static constexpr int SIZE = 256;
+static constexpr int COLUMNS = 4;
+static constexpr unsigned int DRAW_ID_LOCATION = 3;
+
+/* Red is 60 per draw ID, so a column's colour tells which submit() drew it */
+static const char *DRAW_ID_VERTEX = R"(#version 330
+layout(location = 0) in vec2 vPos;
+layout(location = 3) in uint aDrawID;
+flat out uint v_DrawID;
+void main()
+{
+    gl_Position = vec4(vPos, 0.0, 1.0);
+    v_DrawID = aDrawID;
+}
+)";
+
+static const char *DRAW_ID_FRAGMENT = R"(#version 330
+flat in uint v_DrawID;
+out vec4 color;
+void main()
+{
+    color = vec4(float(v_DrawID) * 60.0 / 255.0, 1.0, 0.0, 1.0);
+}
+)";
+
+/* u_MVP places the leftmost column's triangle */
+static const char *TRANSFORM_VERTEX = R"(#version 330
+layout(location = 0) in vec2 vPos;
+uniform mat4 u_MVP;
+void main()
+{
+    gl_Position = u_MVP * vec4(vPos, 0.0, 1.0);
+}
+)";
+
+static const char *TRANSFORM_FRAGMENT = R"(#version 330
+out vec4 color;
+void main()
+{
+    color = vec4(1.0, 1.0, 0.0, 1.0);
+}
+)";
+
+/* Each instance moves the leftmost column's triangle by its own offset and brings its own red */
+static const char *INSTANCED_VERTEX = R"(#version 330
+layout(location = 0) in vec2 vPos;
+layout(location = 1) in vec2 iOffsetRed;
+out float v_Red;
+void main()
+{
+    gl_Position = vec4(vPos.x + iOffsetRed.x, vPos.y, 0.0, 1.0);
+    v_Red = iOffsetRed.y;
+}
+)";
+
+static const char *INSTANCED_FRAGMENT = R"(#version 330
+in float v_Red;
+out vec4 color;
+void main()
+{
+    color = vec4(v_Red, 1.0, 0.0, 1.0);
+}
+)";
+
+static int readRed(int x, int y) {
+    unsigned char pixel[4];
+    GLCall(glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel));
+    return pixel[0];
+}
+
+static int readColumnRed(int column) {
+    return readRed(column * SIZE / COLUMNS + SIZE / COLUMNS / 2, SIZE / 8);
+}
+
+struct Columns {
+    GeometryArena arena;
+    std::vector<MeshRange> meshes;
+
+    explicit Columns(const VertexBufferLayout &layout) : arena(layout, 64, 64) {
+        unsigned int indices[] = {0, 1, 2};
+        for (int column = 0; column < COLUMNS; column++) {
+            float left = -1.f + 2.f * (float) column / COLUMNS, width = 2.f / COLUMNS;
+            float vertices[] = {left, -1.f, left + width, -1.f, left + width * 0.5f, 1.f};
+            meshes.push_back(*arena.allocate(vertices, 3, indices, 3));
+        }
+    }
+};
+
+/* Submitted out of column order with different depths, so sorting reorders them; each column must still show
+ * its own draw's ID. Afterwards the arena's VAO must not be left reading the renderer's draw ID buffer */
+static void checkDrawIDs(Columns &columns, const Shader &shader) {
+    Renderer renderer;
+    renderer.setDrawIDLocation((int) DRAW_ID_LOCATION);
+    GLState::get().viewport(0, 0, SIZE, SIZE);
+    renderer.clear();
+
+    const int order[COLUMNS] = {3, 0, 2, 1};
+    const float depths[COLUMNS] = {0.9f, 0.f, 0.5f, 0.f};
+    unsigned int drawIDs[COLUMNS];
+    for (int i = 0; i < COLUMNS; i++)
+        drawIDs[order[i]] = renderer.submit(columns.arena, columns.meshes[order[i]], shader, 0, depths[i]);
+    renderer.flush();
+
+    for (int column = 0; column < COLUMNS; column++)
+        CHECK(readColumnRed(column) == (int) drawIDs[column] * 60);
+
+    columns.arena.getVertexArray().bind();
+    int enabled = -1, divisor = -1;
+    GLCall(glGetVertexAttribiv(DRAW_ID_LOCATION, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &enabled));
+    GLCall(glGetVertexAttribiv(DRAW_ID_LOCATION, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor));
+    CHECK(enabled == 0);
+    CHECK(divisor == 0);
+}
+
+/* Three transformed draws of the leftmost triangle fill columns 0 to 2; an untransformed one in between must
+ * still see the caller's u_MVP, which moves it to column 3, and find it again once flush() is done */
+static void checkTransforms(Columns &columns) {
+    Shader shader(ShaderProgramSource{TRANSFORM_VERTEX, TRANSFORM_FRAGMENT}, "Transform");
+    Renderer renderer;
+    renderer.setTransformUniform("u_MVP");
+    GLState::get().viewport(0, 0, SIZE, SIZE);
+    renderer.clear();
+
+    const float width = 2.f / COLUMNS;
+    mat4x4 callers;
+    mat4x4_translate(callers, 3.f * width, 0.f, 0.f);
+    shader.bind();
+    shader.setUniformMat4x4("u_MVP", callers);
+
+    mat4x4 transforms[3];
+    for (int column = 0; column < 3; column++) {
+        mat4x4_translate(transforms[column], (float) column * width, 0.f, 0.f);
+        renderer.submit(columns.arena, columns.meshes[0], shader, 0, 0.2f * (float) column, nullptr,
+                        &transforms[column]);
+        if (column == 1)
+            renderer.submit(columns.arena, columns.meshes[0], shader, 0, 0.3f);
+    }
+    renderer.flush();
+
+    for (int column = 0; column < COLUMNS; column++)
+        CHECK(readColumnRed(column) == 255);
+    mat4x4 uniform;
+    GLCall(glGetUniformfv(shader.getRendererID(), shader.getUniformLocation("u_MVP"), &uniform[0][0]));
+    CHECK(std::memcmp(uniform, callers, sizeof(mat4x4)) == 0);
+}
+
+/* Instance i lands in column 3 - i with red 50 (i + 1), so a divisor that stepped per vertex, or not at all,
+ * shows up as wrong colours */
+static void checkInstanced() {
+    const float width = 2.f / COLUMNS;
+    float vertices[] = {-1.f, -1.f, -1.f + width, -1.f, -1.f + width * 0.5f, 1.f};
+    float instances[2 * COLUMNS];
+    for (int i = 0; i < COLUMNS; i++) {
+        instances[2 * i] = (float) (COLUMNS - 1 - i) * width;
+        instances[2 * i + 1] = (float) (50 * (i + 1)) / 255.f;
+    }
+    unsigned int indices[] = {0, 1, 2};
+
+    VertexArray vertexArray;
+    VertexBuffer vertexBuffer(vertices, sizeof(vertices));
+    VertexBufferLayout layout;
+    layout.Push<float>(2, 0);
+    vertexArray.addBuffer(vertexBuffer, layout);
+    VertexBuffer instanceBuffer(instances, sizeof(instances));
+    VertexBufferLayout instanceLayout;
+    instanceLayout.Push<float>(2, 1, 1);
+    vertexArray.addBuffer(instanceBuffer, instanceLayout);
+    IndexBuffer indexBuffer(indices, 3);
+    Shader shader(ShaderProgramSource{INSTANCED_VERTEX, INSTANCED_FRAGMENT}, "Instanced");
+
+    Renderer renderer;
+    GLState::get().viewport(0, 0, SIZE, SIZE);
+    renderer.clear();
+    renderer.drawInstanced(vertexArray, indexBuffer, shader, COLUMNS);
+    for (int column = 0; column < COLUMNS; column++)
+        CHECK(readColumnRed(column) == 50 * (COLUMNS - column));
+}
+
+int main() {
+    if (!createHeadlessContext(4, 5, SIZE, SIZE) && !createHeadlessContext(3, 3, SIZE, SIZE))
+        return EXIT_FAILURE;
+    {
+        Shader shader(ShaderProgramSource{DRAW_ID_VERTEX, DRAW_ID_FRAGMENT}, "Draw ID");
+        VertexBufferLayout layout;
+        layout.Push<float>(2, 0);
+        Columns columns(layout);
+
+        bool indirect = GLAD_GL_ARB_multi_draw_indirect;
+        printf("Multi-draw indirect %s\n", indirect ? "available" : "unavailable");
+        checkDrawIDs(columns, shader);
+        if (indirect) {
+            GLAD_GL_ARB_multi_draw_indirect = 0;
+            checkDrawIDs(columns, shader);
+            GLAD_GL_ARB_multi_draw_indirect = 1;
+        }
+        checkTransforms(columns);
+        checkInstanced();
+
+        GLCall(GLenum error = glGetError());
+        CHECK(error == GL_NO_ERROR);
+    }
+    destroyHeadlessContext();
+    return checkResult("Renderer");
+}
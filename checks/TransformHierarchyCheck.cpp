@@ -0,0 +1,107 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "Check.h"
+#include "Headless.h"
+#include "Renderer.h"
+#include "TransformHierarchy.h"
+#include "VertexBuffer.h"
+
+/* World matrices after dirtying nodes at different depths, and what uploadChanged() writes to the instance buffer */
+
+/* Node ids; NESTED is added last under A, so it lands in the middle of the depth-first order */
+enum Node : unsigned int { ROOT, A, A_LEAF, B, B_LEAF, OTHER_ROOT, OTHER_LEAF, NESTED, NODE_COUNT };
+
+static constexpr float SENTINEL = -7.f;
+
+static void makeLocal(mat4x4 local, unsigned int node, float shift) {
+    mat4x4_translate(local, (float) node + shift, 2.f * (float) node, 0.5f);
+    /* A scale on the roots makes the order of multiplication matter */
+    if (node == ROOT || node == OTHER_ROOT)
+        mat4x4_scale_aniso(local, local, 2.f, 3.f, 0.5f);
+}
+
+static bool nearlyEqual(mat4x4 const a, mat4x4 const b) {
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            if (std::abs(a[column][row] - b[column][row]) > 1e-4f)
+                return false;
+        }
+    }
+    return true;
+}
+
+/* World matrices the slow way, walking up to the root */
+static bool worldsMatch(const TransformHierarchy &hierarchy) {
+    bool match = true;
+    for (unsigned int node = 0; node < hierarchy.getNodeCount(); node++) {
+        mat4x4 expected;
+        mat4x4_dup(expected, hierarchy.getLocal(node));
+        for (unsigned int parent = hierarchy.getParent(node); parent != TransformHierarchy::NO_PARENT;
+             parent = hierarchy.getParent(parent)) {
+            mat4x4 product;
+            mat4x4_mul(product, hierarchy.getLocal(parent), expected);
+            mat4x4_dup(expected, product);
+        }
+        match &= nearlyEqual(hierarchy.getWorld(node), expected);
+    }
+    return match;
+}
+
+int main() {
+    if (!createHeadlessContext(3, 3))
+        return EXIT_FAILURE;
+    {
+        static const unsigned int parents[NODE_COUNT] = {
+            TransformHierarchy::NO_PARENT, ROOT, A, ROOT, B, TransformHierarchy::NO_PARENT, OTHER_ROOT, A
+        };
+        TransformHierarchy hierarchy;
+        for (unsigned int node = 0; node < NODE_COUNT; node++) {
+            mat4x4 local;
+            makeLocal(local, node, 0.f);
+            CHECK(hierarchy.add(parents[node], local) == node);
+        }
+        CHECK(hierarchy.getParent(NESTED) == A);
+        CHECK(hierarchy.update() == NODE_COUNT);
+        CHECK(worldsMatch(hierarchy));
+        CHECK(hierarchy.update() == 0);
+        CHECK(hierarchy.getChangedSlots().empty());
+
+        /* The leaf is dirtied before its ancestor and must be skipped inside the ancestor's subtree, which
+         * holds NESTED too; the other root's leaf makes a second run */
+        mat4x4 local;
+        makeLocal(local, A_LEAF, 1.f);
+        hierarchy.setLocal(A_LEAF, local);
+        makeLocal(local, OTHER_LEAF, 1.f);
+        hierarchy.setLocal(OTHER_LEAF, local);
+        makeLocal(local, A, 1.f);
+        hierarchy.setLocal(A, local);
+        CHECK(hierarchy.update() == 4);
+        CHECK((hierarchy.getChangedSlots() == std::vector<unsigned int>{A, A_LEAF, NESTED, OTHER_LEAF}));
+        CHECK(worldsMatch(hierarchy));
+
+        /* One spare matrix ahead of slot 0 to exercise [offset]; untouched slots keep the sentinel */
+        std::vector<float> initial((NODE_COUNT + 1) * 16, SENTINEL);
+        VertexBuffer buffer(initial.data(), (unsigned int) (initial.size() * sizeof(float)));
+        hierarchy.uploadChanged(buffer, sizeof(mat4x4));
+
+        std::vector<float> uploaded(initial.size());
+        buffer.bind();
+        GLCall(glGetBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) (uploaded.size() * sizeof(float)),
+                                  uploaded.data()));
+        CHECK(uploaded[0] == SENTINEL && uploaded[15] == SENTINEL);
+        for (unsigned int node = 0; node < NODE_COUNT; node++) {
+            const float *slot = uploaded.data() + (node + 1) * 16;
+            bool changed = node == A || node == A_LEAF || node == NESTED || node == OTHER_LEAF;
+            if (changed)
+                CHECK(std::memcmp(slot, hierarchy.getWorld(node), sizeof(mat4x4)) == 0);
+            else
+                CHECK(slot[0] == SENTINEL && slot[15] == SENTINEL);
+        }
+
+        GLCall(GLenum error = glGetError());
+        CHECK(error == GL_NO_ERROR);
+    }
+    destroyHeadlessContext();
+    return checkResult("Transform hierarchy");
+}
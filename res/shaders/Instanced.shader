@@ -0,0 +1,20 @@
+#shader vertex
+#version 330
+layout (location = 0) in vec3 vCol;
+layout (location = 1) in vec2 vPos;
+layout (location = 2) in mat4 iMVP; /* Per instance, locations 2 to 5 */
+out vec3 vColor;
+void main()
+{
+    gl_Position = iMVP * vec4(vPos, 0.0, 1.0);
+    vColor = vCol;
+}
+
+#shader fragment
+#version 330
+in vec3 vColor;
+out vec4 color;
+void main()
+{
+    color = vec4(vColor, 1.0);
+}
@@ -0,0 +1,20 @@
+#shader vertex
+#version 330
+/* VertexPuller::injectFetchCode() inserts pullVertex() and pullAttribute<location>() here */
+uniform mat4 u_MVP;
+out vec3 vColor;
+void main()
+{
+    uint vertex = pullVertex();
+    gl_Position = u_MVP * vec4(pullAttribute1(vertex).xy, 0.0, 1.0);
+    vColor = pullAttribute0(vertex).rgb;
+}
+
+#shader fragment
+#version 330
+in vec3 vColor;
+out vec4 color;
+void main()
+{
+    color = vec4(vColor, 1.0);
+}
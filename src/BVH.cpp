@@ -0,0 +1,506 @@
+#include <algorithm>
+#include <array>
+#include "BVH.h"
+#include "ThreadPool.h"
+#include "Float4.h"
+
+static constexpr unsigned int BIN_COUNT = 16;
+static constexpr uint32_t MAX_LEAF_SIZE = 8;
+/* Cost of visiting a node relative to testing one object's bounds */
+static constexpr float TRAVERSAL_COST = 1.f;
+/* Nodes with more objects than this bin them across the pool */
+static constexpr uint32_t PARALLEL_BIN_MIN = 64 * 1024;
+static constexpr size_t PARALLEL_BIN_GRAIN = 16 * 1024;
+/* Subtrees handed to the pool have at least this many objects, however many threads there are */
+static constexpr uint32_t MIN_SUBTREE_SIZE = 4096;
+
+static AABB emptyBox() {
+    return {{INFINITY, INFINITY, INFINITY}, {-INFINITY, -INFINITY, -INFINITY}};
+}
+
+static void growBox(AABB &box, const AABB &other) {
+    for (int axis = 0; axis < 3; axis++) {
+        box.min[axis] = std::min(box.min[axis], other.min[axis]);
+        box.max[axis] = std::max(box.max[axis], other.max[axis]);
+    }
+}
+
+/* Half the surface area, which is all the heuristic's ratios need */
+static float halfArea(const AABB &box) {
+    float x = box.max[0] - box.min[0], y = box.max[1] - box.min[1], z = box.max[2] - box.min[2];
+    return x < 0.f ? 0.f : x * y + y * z + z * x;
+}
+
+static bool overlaps(const AABB &a, const AABB &b) {
+    for (int axis = 0; axis < 3; axis++) {
+        if (a.max[axis] < b.min[axis] || b.max[axis] < a.min[axis])
+            return false;
+    }
+    return true;
+}
+
+/* The build works on boxes as two float4s, the fourth lane unused */
+struct Box4 {
+    float4 min = broadcast4(INFINITY);
+    float4 max = broadcast4(-INFINITY);
+
+    void grow(const Box4 &other) {
+        min = min4(min, other.min);
+        max = max4(max, other.max);
+    }
+
+    float halfArea() const {
+        float4 extent = sub4(max, min);
+        float products[4];
+        store4(products, mul4(extent, swizzle4<1, 2, 0, 3>(extent)));
+        return products[0] + products[1] + products[2];
+    }
+
+    AABB toAABB() const {
+        float low[4], high[4];
+        store4(low, min);
+        store4(high, max);
+        return {{low[0], low[1], low[2]}, {high[0], high[1], high[2]}};
+    }
+};
+
+static Box4 loadBox(const float *min, const float *max) {
+    Box4 box;
+    box.min = load4(min);
+    box.max = load4(max);
+    return box;
+}
+
+struct Bin {
+    Box4 bounds;
+    uint32_t count = 0;
+};
+
+using AxisBins = std::array<std::array<Bin, BIN_COUNT>, 3>;
+
+/* Maps centroids to bins along all three axes of the centroid bounds at once */
+struct Binning {
+    float4 origin;
+    float4 scale; /* Bin count / extent, 0 on flat axes */
+    float4 last;
+
+    void binsOf(const Box4 &box, float *bins) const {
+        float4 centroid = mul4(add4(box.min, box.max), broadcast4(0.5f));
+        float4 bin = mul4(sub4(centroid, origin), scale);
+        store4(bins, min4(max4(bin, broadcast4(0.f)), last));
+    }
+};
+
+void BVH::build(const AABB *bounds, size_t count, ThreadPool *pool) {
+    m_Bounds.assign(bounds, bounds + count);
+    m_Objects.resize(count);
+    m_Nodes.clear();
+    m_Blocks.clear();
+    m_Moved.clear();
+    m_Dirty.clear();
+    m_TopNodeCount = 0;
+    if (count == 0) {
+        m_Parents.clear();
+        m_LeafOf.clear();
+        return;
+    }
+
+    auto fillItems = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            BuildItem &item = m_Items[i];
+            for (int axis = 0; axis < 3; axis++) {
+                item.min[axis] = m_Bounds[i].min[axis];
+                item.max[axis] = m_Bounds[i].max[axis];
+            }
+            item.min[3] = item.max[3] = 0.f;
+            item.object = (uint32_t) i;
+        }
+    };
+    m_Items.resize(count);
+    if (pool)
+        pool->parallelFor(count, PARALLEL_BIN_GRAIN, fillItems);
+    else
+        fillItems(0, count);
+
+    AABB rootBounds = emptyBox();
+    for (const AABB &box: m_Bounds)
+        growBox(rootBounds, box);
+    m_Nodes.push_back({rootBounds, 0, (uint32_t) count});
+
+    if (!pool || pool->getThreadCount() == 1) {
+        buildSubtree(m_Nodes, 0);
+        m_TopNodeCount = (uint32_t) m_Nodes.size();
+    } else {
+        /* Split the top of the tree here until nodes are small enough to be spread over the threads */
+        uint32_t subtreeSize = std::max<uint32_t>(MIN_SUBTREE_SIZE, (uint32_t) (count / (pool->getThreadCount() * 8)));
+        std::vector<uint32_t> pending = {0}, subtrees;
+        while (!pending.empty()) {
+            uint32_t node = pending.back();
+            pending.pop_back();
+            if (m_Nodes[node].count <= subtreeSize) {
+                subtrees.push_back(node);
+            } else if (splitNode(m_Nodes, node, pool)) {
+                pending.push_back(m_Nodes[node].index + 1);
+                pending.push_back(m_Nodes[node].index);
+            }
+        }
+        m_TopNodeCount = (uint32_t) m_Nodes.size();
+
+        std::vector<std::vector<Node>> built(subtrees.size());
+        pool->parallelFor(subtrees.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                built[i].push_back(m_Nodes[subtrees[i]]);
+                buildSubtree(built[i], 0);
+            }
+        });
+
+        /* Each subtree's root replaces its placeholder; the rest is appended with child indices rebased */
+        for (size_t i = 0; i < subtrees.size(); i++) {
+            auto base = (uint32_t) m_Nodes.size();
+            for (Node &node: built[i]) {
+                if (node.count == 0)
+                    node.index = base + node.index - 1;
+            }
+            m_Nodes[subtrees[i]] = built[i][0];
+            m_Nodes.insert(m_Nodes.end(), built[i].begin() + 1, built[i].end());
+            if (m_Nodes.size() > base)
+                m_Blocks.push_back({base, (uint32_t) m_Nodes.size()});
+        }
+    }
+    for (size_t i = 0; i < count; i++)
+        m_Objects[i] = m_Items[i].object;
+    m_Items.clear();
+    m_Items.shrink_to_fit();
+
+    m_Parents.assign(m_Nodes.size(), NO_NODE);
+    m_LeafOf.resize(count);
+    for (uint32_t node = 0; node < m_Nodes.size(); node++) {
+        const Node &current = m_Nodes[node];
+        if (current.count == 0) {
+            m_Parents[current.index] = node;
+            m_Parents[current.index + 1] = node;
+        } else {
+            for (uint32_t i = current.index; i < current.index + current.count; i++)
+                m_LeafOf[m_Objects[i]] = node;
+        }
+    }
+    m_Dirty.assign(m_Nodes.size(), false);
+}
+
+void BVH::buildSubtree(std::vector<Node> &nodes, uint32_t root) {
+    std::vector<uint32_t> pending = {root};
+    while (!pending.empty()) {
+        uint32_t node = pending.back();
+        pending.pop_back();
+        if (splitNode(nodes, node, nullptr)) {
+            pending.push_back(nodes[node].index + 1);
+            pending.push_back(nodes[node].index);
+        }
+    }
+}
+
+/* Picks the cheapest of the planes between bins on each axis, or keeps the node as a leaf when
+ * that is cheaper and small enough. Children are appended to [nodes]; returns whether the node was split */
+bool BVH::splitNode(std::vector<Node> &nodes, uint32_t node, ThreadPool *pool) {
+    const Node parent = nodes[node];
+    if (parent.count <= 2)
+        return false;
+
+    BuildItem *items = m_Items.data() + parent.index;
+    bool parallel = pool && parent.count >= PARALLEL_BIN_MIN;
+
+    Box4 centroidBounds;
+    for (uint32_t i = 0; i < parent.count; i++) {
+        Box4 box = loadBox(items[i].min, items[i].max);
+        float4 centroid = mul4(add4(box.min, box.max), broadcast4(0.5f));
+        centroidBounds.min = min4(centroidBounds.min, centroid);
+        centroidBounds.max = max4(centroidBounds.max, centroid);
+    }
+
+    /* Small nodes get one bin per object, which saves sweeping empty bins near the leaves */
+    unsigned int binCount = std::min<uint32_t>(BIN_COUNT, parent.count);
+    float extents[4], scales[4];
+    store4(extents, sub4(centroidBounds.max, centroidBounds.min));
+    for (int axis = 0; axis < 4; axis++)
+        scales[axis] = axis < 3 && extents[axis] > 0.f ? (float) binCount / extents[axis] : 0.f;
+    Binning binning{centroidBounds.min, load4(scales), broadcast4((float) (binCount - 1))};
+
+    auto fillBins = [&](AxisBins &bins, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            Box4 box = loadBox(items[i].min, items[i].max);
+            float binIndices[4];
+            binning.binsOf(box, binIndices);
+            for (int axis = 0; axis < 3; axis++) {
+                Bin &bin = bins[axis][(unsigned int) binIndices[axis]];
+                bin.bounds.grow(box);
+                bin.count++;
+            }
+        }
+    };
+    AxisBins bins{};
+    if (parallel) {
+        std::vector<AxisBins> chunks((parent.count + PARALLEL_BIN_GRAIN - 1) / PARALLEL_BIN_GRAIN);
+        pool->parallelFor(parent.count, PARALLEL_BIN_GRAIN, [&](size_t begin, size_t end) {
+            fillBins(chunks[begin / PARALLEL_BIN_GRAIN], begin, end);
+        });
+        for (const AxisBins &chunk: chunks) {
+            for (int axis = 0; axis < 3; axis++) {
+                for (unsigned int b = 0; b < binCount; b++) {
+                    bins[axis][b].bounds.grow(chunk[axis][b].bounds);
+                    bins[axis][b].count += chunk[axis][b].count;
+                }
+            }
+        }
+    } else {
+        fillBins(bins, 0, parent.count);
+    }
+
+    /* Sweep from both ends so every plane's cost comes out of two running unions */
+    float bestCost = INFINITY;
+    int bestAxis = -1;
+    unsigned int bestSplit = 0;
+    AABB bestLeft{}, bestRight{};
+    for (int axis = 0; axis < 3; axis++) {
+        if (scales[axis] == 0.f)
+            continue;
+
+        std::array<Box4, BIN_COUNT> rightBounds;
+        std::array<uint32_t, BIN_COUNT> rightCounts{};
+        Box4 right;
+        uint32_t rightCount = 0;
+        for (unsigned int b = binCount - 1; b > 0; b--) {
+            right.grow(bins[axis][b].bounds);
+            rightCount += bins[axis][b].count;
+            rightBounds[b] = right;
+            rightCounts[b] = rightCount;
+        }
+
+        Box4 left;
+        uint32_t leftCount = 0;
+        for (unsigned int b = 0; b + 1 < binCount; b++) {
+            left.grow(bins[axis][b].bounds);
+            leftCount += bins[axis][b].count;
+            if (leftCount == 0 || rightCounts[b + 1] == 0)
+                continue;
+            float cost = left.halfArea() * (float) leftCount + rightBounds[b + 1].halfArea() * (float) rightCounts[b + 1];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+                bestLeft = left.toAABB();
+                bestRight = rightBounds[b + 1].toAABB();
+            }
+        }
+    }
+
+    float leafCost = halfArea(parent.bounds) * (float) parent.count;
+    float splitCost = TRAVERSAL_COST * halfArea(parent.bounds) + bestCost;
+    if (parent.count <= MAX_LEAF_SIZE && (bestAxis < 0 || splitCost >= leafCost))
+        return false;
+
+    uint32_t leftCount;
+    if (bestAxis >= 0) {
+        BuildItem *middle = std::partition(items, items + parent.count, [&](const BuildItem &item) {
+            float binIndices[4];
+            binning.binsOf(loadBox(item.min, item.max), binIndices);
+            return (unsigned int) binIndices[bestAxis] <= bestSplit;
+        });
+        leftCount = (uint32_t) (middle - items);
+    } else {
+        /* Every centroid is the same point: halve the list so leaves stay small */
+        leftCount = parent.count / 2;
+        Box4 halves[2];
+        for (uint32_t i = 0; i < parent.count; i++)
+            halves[i < leftCount ? 0 : 1].grow(loadBox(items[i].min, items[i].max));
+        bestLeft = halves[0].toAABB();
+        bestRight = halves[1].toAABB();
+    }
+
+    auto first = (uint32_t) nodes.size();
+    nodes.push_back({bestLeft, parent.index, leftCount});
+    nodes.push_back({bestRight, parent.index + leftCount, parent.count - leftCount});
+    nodes[node].index = first;
+    nodes[node].count = 0;
+    return true;
+}
+
+void BVH::update(uint32_t object, const AABB &bounds) {
+    m_Bounds[object] = bounds;
+    m_Moved.push_back(object);
+}
+
+void BVH::refitNode(uint32_t node) {
+    Node &current = m_Nodes[node];
+    if (current.count == 0) {
+        current.bounds = m_Nodes[current.index].bounds;
+        growBox(current.bounds, m_Nodes[current.index + 1].bounds);
+    } else {
+        current.bounds = emptyBox();
+        for (uint32_t i = current.index; i < current.index + current.count; i++)
+            growBox(current.bounds, m_Bounds[m_Objects[i]]);
+    }
+}
+
+void BVH::refit(ThreadPool *pool) {
+    if (m_Moved.empty())
+        return;
+
+    /* Children always come after their parent, so a reverse walk refits bottom up */
+    if (m_Moved.size() * 16 >= m_Bounds.size()) {
+        if (pool) {
+            pool->parallelFor(m_Blocks.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    for (uint32_t node = m_Blocks[i].end; node-- > m_Blocks[i].first;)
+                        refitNode(node);
+                }
+            });
+        } else {
+            for (size_t i = m_Blocks.size(); i-- > 0;) {
+                for (uint32_t node = m_Blocks[i].end; node-- > m_Blocks[i].first;)
+                    refitNode(node);
+            }
+        }
+        for (uint32_t node = m_TopNodeCount; node-- > 0;)
+            refitNode(node);
+    } else {
+        /* Mark the moved objects' ancestors, stopping at paths already marked, then refit those deepest first */
+        m_RefitNodes.clear();
+        for (uint32_t object: m_Moved) {
+            for (uint32_t node = m_LeafOf[object]; node != NO_NODE && !m_Dirty[node]; node = m_Parents[node]) {
+                m_Dirty[node] = true;
+                m_RefitNodes.push_back(node);
+            }
+        }
+        std::sort(m_RefitNodes.begin(), m_RefitNodes.end(), std::greater<>());
+        for (uint32_t node: m_RefitNodes) {
+            refitNode(node);
+            m_Dirty[node] = false;
+        }
+    }
+    m_Moved.clear();
+}
+
+void BVH::cull(const Frustum &frustum, std::vector<uint32_t> &visible) const {
+    if (m_Nodes.empty())
+        return;
+
+    /* Low bit of each entry: the node is known to be inside */
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty()) {
+        uint32_t entry = stack.back();
+        stack.pop_back();
+        const Node &node = m_Nodes[entry >> 1];
+        bool inside = entry & 1;
+        if (!inside) {
+            Containment containment = frustum.classify(node.bounds);
+            if (containment == Containment::OUTSIDE)
+                continue;
+            inside = containment == Containment::INSIDE;
+        }
+
+        if (node.count == 0) {
+            stack.push_back((node.index + 1) << 1 | inside);
+            stack.push_back(node.index << 1 | inside);
+        } else {
+            for (uint32_t i = node.index; i < node.index + node.count; i++) {
+                if (inside || frustum.intersects(m_Bounds[m_Objects[i]]))
+                    visible.push_back(m_Objects[i]);
+            }
+        }
+    }
+}
+
+void BVH::query(const AABB &box, std::vector<uint32_t> &results) const {
+    if (m_Nodes.empty())
+        return;
+
+    std::vector<uint32_t> stack = {0};
+    while (!stack.empty()) {
+        const Node &node = m_Nodes[stack.back()];
+        stack.pop_back();
+        if (!overlaps(node.bounds, box))
+            continue;
+
+        if (node.count == 0) {
+            stack.push_back(node.index + 1);
+            stack.push_back(node.index);
+        } else {
+            for (uint32_t i = node.index; i < node.index + node.count; i++) {
+                if (overlaps(m_Bounds[m_Objects[i]], box))
+                    results.push_back(m_Objects[i]);
+            }
+        }
+    }
+}
+
+/* Slab test: distance at which the ray enters [box], or INFINITY if it misses it within [limit] */
+static float rayEntry(const AABB &box, const float *origin, const float *inverseDirection, float limit) {
+    float near = 0.f, far = limit;
+    for (int axis = 0; axis < 3; axis++) {
+        float t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        float t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        /* fmin/fmax drop the NaN of a ray lying in a slab plane */
+        near = std::fmax(near, std::fmin(t0, t1));
+        far = std::fmin(far, std::fmax(t0, t1));
+    }
+    return near <= far ? near : INFINITY;
+}
+
+std::optional<RayHit> BVH::raycast(vec3 const origin, vec3 const direction, float maxDistance,
+                                   const std::function<std::optional<float>(uint32_t)> &exactTest) const {
+    if (m_Nodes.empty())
+        return std::nullopt;
+
+    vec3 inverseDirection = {1.f / direction[0], 1.f / direction[1], 1.f / direction[2]};
+    std::optional<RayHit> closest;
+    float limit = maxDistance;
+
+    struct Entry {
+        uint32_t node;
+        float entry;
+    };
+    std::vector<Entry> stack;
+    float rootEntry = rayEntry(m_Nodes[0].bounds, origin, inverseDirection, limit);
+    if (rootEntry != INFINITY)
+        stack.push_back({0, rootEntry});
+
+    while (!stack.empty()) {
+        Entry top = stack.back();
+        stack.pop_back();
+        if (top.entry > limit)
+            continue; /* Something nearer was found since this node was pushed */
+
+        const Node &node = m_Nodes[top.node];
+        if (node.count == 0) {
+            /* Visit the nearer child first so hits found there prune the other */
+            uint32_t near = node.index, far = node.index + 1;
+            float nearEntry = rayEntry(m_Nodes[near].bounds, origin, inverseDirection, limit);
+            float farEntry = rayEntry(m_Nodes[far].bounds, origin, inverseDirection, limit);
+            if (farEntry < nearEntry) {
+                std::swap(near, far);
+                std::swap(nearEntry, farEntry);
+            }
+            if (farEntry != INFINITY)
+                stack.push_back({far, farEntry});
+            if (nearEntry != INFINITY)
+                stack.push_back({near, nearEntry});
+            continue;
+        }
+
+        for (uint32_t i = node.index; i < node.index + node.count; i++) {
+            uint32_t object = m_Objects[i];
+            float distance = rayEntry(m_Bounds[object], origin, inverseDirection, limit);
+            if (distance == INFINITY)
+                continue;
+            if (exactTest) {
+                std::optional<float> exact = exactTest(object);
+                if (!exact || *exact > limit)
+                    continue;
+                distance = *exact;
+            }
+            limit = distance;
+            closest = RayHit{object, distance};
+        }
+    }
+    return closest;
+}
@@ -0,0 +1,92 @@
+#ifndef OPENGL_BVH_H
+#define OPENGL_BVH_H
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "Frustum.h"
+
+class ThreadPool;
+
+struct RayHit {
+    uint32_t object;
+    float distance; /* Along the ray direction, in units of its length */
+};
+
+/* Bounding volume hierarchy over object AABBs, built with the binned surface area heuristic. Nodes live in one
+ * array where children always come after their parent and next to each other, and every node's objects are
+ * one contiguous range of the object list.
+ * Moving objects are handled by refitting: update() records new bounds and refit() grows or shrinks the boxes
+ * above them. The tree's shape is kept, so after large rearrangements a rebuild gives faster queries.
+ * Object ids are indices into the bounds passed to build(). Queries return ids to submit to the Renderer
+ * directly, in place of its linear setCullFrustum() pass */
+class BVH {
+private:
+    struct Node {
+        AABB bounds;
+        uint32_t index; /* First child when count is 0 (the second follows it), else first entry of m_Objects */
+        uint32_t count; /* Objects in a leaf, 0 for internal nodes */
+    };
+
+    /* An object's bounds, padded to four floats a side for the build's vector loops and moved along with the
+     * object while build() partitions, so binning reads memory in order rather than following object ids */
+    struct alignas(16) BuildItem {
+        float min[4];
+        float max[4];
+        uint32_t object;
+    };
+
+    /* Nodes [first, end) form one subtree built on its own by a thread, refit on its own too */
+    struct Block {
+        uint32_t first;
+        uint32_t end;
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<uint32_t> m_Parents;  /* Per node, NO_NODE for the root */
+    std::vector<uint32_t> m_Objects;  /* Object ids in leaf order */
+    std::vector<AABB> m_Bounds;       /* Per object */
+    std::vector<uint32_t> m_LeafOf;   /* Per object */
+    std::vector<BuildItem> m_Items;   /* Only during build() */
+    std::vector<Block> m_Blocks;
+    uint32_t m_TopNodeCount = 0;      /* Nodes before the first block, built and refit on the calling thread */
+
+    std::vector<uint32_t> m_Moved;
+    std::vector<uint32_t> m_RefitNodes;
+    std::vector<bool> m_Dirty;
+
+public:
+    static constexpr uint32_t NO_NODE = ~0u;
+
+    /* Replaces the whole tree. With a pool, large nodes are binned in parallel and once there are enough
+     * independent subtrees they are built one per task */
+    void build(const AABB *bounds, size_t count, ThreadPool *pool = nullptr);
+
+    /* Records an object's new bounds; queries see them after the next refit() */
+    void update(uint32_t object, const AABB &bounds);
+    /* Brings node bounds up to date after update() calls: only the moved objects' ancestors when few moved,
+     * otherwise the whole tree, a subtree per task with a pool */
+    void refit(ThreadPool *pool = nullptr);
+
+    /* Appends the objects whose bounds touch the frustum; subtrees wholly inside are taken without tests */
+    void cull(const Frustum &frustum, std::vector<uint32_t> &visible) const;
+    /* Appends the objects whose bounds overlap [box] */
+    void query(const AABB &box, std::vector<uint32_t> &results) const;
+    /* Nearest object along the ray within [maxDistance]. Without [exactTest] an object is hit where the ray enters
+     * its bounds; with it, each object whose bounds the ray crosses is asked for its own hit distance, if any */
+    std::optional<RayHit> raycast(vec3 const origin, vec3 const direction, float maxDistance = INFINITY,
+                                  const std::function<std::optional<float>(uint32_t object)> &exactTest = nullptr) const;
+
+    inline const AABB &getBounds(uint32_t object) const { return m_Bounds[object]; }
+    inline size_t getObjectCount() const { return m_Bounds.size(); }
+    inline size_t getNodeCount() const { return m_Nodes.size(); }
+
+private:
+    bool splitNode(std::vector<Node> &nodes, uint32_t node, ThreadPool *pool);
+    void buildSubtree(std::vector<Node> &nodes, uint32_t root);
+    void refitNode(uint32_t node);
+};
+
+#endif //OPENGL_BVH_H
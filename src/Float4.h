@@ -0,0 +1,105 @@
+#ifndef OPENGL_FLOAT4_H
+#define OPENGL_FLOAT4_H
+
+/* A 4-wide float type with just the operations the vector kernels need, so each is written once for SSE2,
+ * NEON and scalar code. OPENGL_SIMD_SSE2 / OPENGL_SIMD_NEON tell which one was picked */
+#if defined(__SSE2__)
+#define OPENGL_SIMD_SSE2
+#include <immintrin.h>
+
+using float4 = __m128;
+
+inline float4 load4(const float *p) { return _mm_loadu_ps(p); }
+inline void store4(float *p, float4 v) { _mm_storeu_ps(p, v); }
+inline float4 set4(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline float4 broadcast4(float x) { return _mm_set1_ps(x); }
+inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub4(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul4(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 madd4(float4 a, float4 b, float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline float4 div4(float4 a, float4 b) { return _mm_div_ps(a, b); }
+inline float4 min4(float4 a, float4 b) { return _mm_min_ps(a, b); }
+inline float4 max4(float4 a, float4 b) { return _mm_max_ps(a, b); }
+/* Bit i set where a[i] < b[i] */
+inline int lessMask4(float4 a, float4 b) { return _mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+
+template<int X, int Y, int Z, int W>
+inline float4 swizzle4(float4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X)); }
+
+inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d) { _MM_TRANSPOSE4_PS(a, b, c, d); }
+
+#elif defined(__aarch64__)
+#define OPENGL_SIMD_NEON
+#include <arm_neon.h>
+
+using float4 = float32x4_t;
+
+inline float4 load4(const float *p) { return vld1q_f32(p); }
+inline void store4(float *p, float4 v) { vst1q_f32(p, v); }
+inline float4 set4(float x, float y, float z, float w) { return float4{x, y, z, w}; }
+inline float4 broadcast4(float x) { return vdupq_n_f32(x); }
+inline float4 add4(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline float4 sub4(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline float4 mul4(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline float4 madd4(float4 a, float4 b, float4 c) { return vfmaq_f32(c, a, b); }
+inline float4 div4(float4 a, float4 b) { return vdivq_f32(a, b); }
+inline float4 min4(float4 a, float4 b) { return vminq_f32(a, b); }
+inline float4 max4(float4 a, float4 b) { return vmaxq_f32(a, b); }
+inline int lessMask4(float4 a, float4 b) {
+    const uint32x4_t bits = {1, 2, 4, 8};
+    return (int) vaddvq_u32(vandq_u32(vcltq_f32(a, b), bits));
+}
+
+template<int X, int Y, int Z, int W>
+inline float4 swizzle4(float4 v) { return __builtin_shufflevector(v, v, X, Y, Z, W); }
+
+inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d) {
+    float32x4x2_t ab = vtrnq_f32(a, b), cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+#else
+struct float4 {
+    float v[4];
+};
+
+inline float4 load4(const float *p) { return {p[0], p[1], p[2], p[3]}; }
+inline void store4(float *p, float4 v) { for (int i = 0; i < 4; i++) p[i] = v.v[i]; }
+inline float4 set4(float x, float y, float z, float w) { return {x, y, z, w}; }
+inline float4 broadcast4(float x) { return {x, x, x, x}; }
+inline float4 add4(float4 a, float4 b) { return {a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}; }
+inline float4 sub4(float4 a, float4 b) { return {a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}; }
+inline float4 mul4(float4 a, float4 b) { return {a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}; }
+inline float4 madd4(float4 a, float4 b, float4 c) { return add4(mul4(a, b), c); }
+inline float4 div4(float4 a, float4 b) { return {a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}; }
+inline float4 min4(float4 a, float4 b) {
+    return {a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1],
+            a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3]};
+}
+inline float4 max4(float4 a, float4 b) {
+    return {a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1],
+            a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3]};
+}
+inline int lessMask4(float4 a, float4 b) {
+    return (a.v[0] < b.v[0]) | (a.v[1] < b.v[1]) << 1 | (a.v[2] < b.v[2]) << 2 | (a.v[3] < b.v[3]) << 3;
+}
+
+template<int X, int Y, int Z, int W>
+inline float4 swizzle4(float4 v) { return {v.v[X], v.v[Y], v.v[Z], v.v[W]}; }
+
+inline void transpose4(float4 &a, float4 &b, float4 &c, float4 &d) {
+    float4 rows[4] = {a, b, c, d};
+    a = {rows[0].v[0], rows[1].v[0], rows[2].v[0], rows[3].v[0]};
+    b = {rows[0].v[1], rows[1].v[1], rows[2].v[1], rows[3].v[1]};
+    c = {rows[0].v[2], rows[1].v[2], rows[2].v[2], rows[3].v[2]};
+    d = {rows[0].v[3], rows[1].v[3], rows[2].v[3], rows[3].v[3]};
+}
+#endif
+
+template<int I>
+inline float4 splat4(float4 v) { return swizzle4<I, I, I, I>(v); }
+
+#endif //OPENGL_FLOAT4_H
@@ -0,0 +1,64 @@
+#include "FreeListAllocator.h"
+
+FreeListAllocator::FreeListAllocator(unsigned int capacity) : m_Capacity(capacity), m_Used(0) {
+    if (capacity > 0)
+        insertBlock(0, capacity);
+}
+
+unsigned int FreeListAllocator::allocate(unsigned int size) {
+    if (size == 0)
+        return INVALID_OFFSET;
+
+    /* Smallest block that fits, keeping large blocks intact for large meshes */
+    auto fit = m_BlocksBySize.lower_bound(size);
+    if (fit == m_BlocksBySize.end())
+        return INVALID_OFFSET;
+
+    unsigned int offset = fit->second;
+    unsigned int blockSize = fit->first;
+    eraseBlock(m_BlocksByOffset.find(offset));
+    if (blockSize > size)
+        insertBlock(offset + size, blockSize - size);
+
+    m_Used += size;
+    return offset;
+}
+
+void FreeListAllocator::free(unsigned int offset, unsigned int size) {
+    if (size == 0)
+        return;
+    m_Used -= size;
+
+    /* Merge with the free blocks directly after and before the range */
+    auto next = m_BlocksByOffset.lower_bound(offset);
+    if (next != m_BlocksByOffset.end() && next->first == offset + size) {
+        size += next->second;
+        next = std::next(next);
+        eraseBlock(std::prev(next));
+    }
+    if (next != m_BlocksByOffset.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            eraseBlock(previous);
+        }
+    }
+    insertBlock(offset, size);
+}
+
+void FreeListAllocator::insertBlock(unsigned int offset, unsigned int size) {
+    m_BlocksByOffset.emplace(offset, size);
+    m_BlocksBySize.emplace(size, offset);
+}
+
+void FreeListAllocator::eraseBlock(std::map<unsigned int, unsigned int>::iterator block) {
+    auto [first, last] = m_BlocksBySize.equal_range(block->second);
+    for (auto it = first; it != last; ++it) {
+        if (it->second == block->first) {
+            m_BlocksBySize.erase(it);
+            break;
+        }
+    }
+    m_BlocksByOffset.erase(block);
+}
@@ -0,0 +1,32 @@
+#ifndef OPENGL_FREELISTALLOCATOR_H
+#define OPENGL_FREELISTALLOCATOR_H
+
+#include <map>
+
+/* Hands out ranges of [0, capacity) in abstract units (bytes, vertices, indices).
+ * Free blocks are indexed by offset, to merge neighbours on free, and by size, for best-fit allocation */
+class FreeListAllocator {
+private:
+    std::map<unsigned int, unsigned int> m_BlocksByOffset;      /* offset -> size */
+    std::multimap<unsigned int, unsigned int> m_BlocksBySize;   /* size -> offset */
+    unsigned int m_Capacity;
+    unsigned int m_Used;
+
+public:
+    static constexpr unsigned int INVALID_OFFSET = ~0u;
+
+    explicit FreeListAllocator(unsigned int capacity);
+
+    /* Returns INVALID_OFFSET when no free block is large enough */
+    [[nodiscard]] unsigned int allocate(unsigned int size);
+    void free(unsigned int offset, unsigned int size);
+
+    inline unsigned int getCapacity() const { return m_Capacity; }
+    inline unsigned int getUsed() const { return m_Used; }
+
+private:
+    void insertBlock(unsigned int offset, unsigned int size);
+    void eraseBlock(std::map<unsigned int, unsigned int>::iterator block);
+};
+
+#endif //OPENGL_FREELISTALLOCATOR_H
@@ -0,0 +1,172 @@
+#include <cmath>
+#include "Frustum.h"
+#include "Float4.h"
+
+BoundingSphere makeBoundingSphere(const AABB &box) {
+    BoundingSphere sphere{};
+    vec3 extent;
+    for (int axis = 0; axis < 3; axis++) {
+        sphere.center[axis] = (box.min[axis] + box.max[axis]) * 0.5f;
+        extent[axis] = (box.max[axis] - box.min[axis]) * 0.5f;
+    }
+    sphere.radius = vec3_len(extent);
+    return sphere;
+}
+
+BoundingSphere transformBounds(const BoundingSphere &sphere, mat4x4 const model) {
+    BoundingSphere result{};
+    float largestScale = 0.f;
+    for (int row = 0; row < 3; row++) {
+        result.center[row] = model[0][row] * sphere.center[0] + model[1][row] * sphere.center[1] +
+                             model[2][row] * sphere.center[2] + model[3][row];
+        largestScale = fmaxf(largestScale, vec3_len(model[row])); /* Length of column [row] */
+    }
+    result.radius = sphere.radius * largestScale;
+    return result;
+}
+
+/* Arvo's method: each output extent is the sum of the input extents weighted by the absolute matrix entries */
+AABB transformBounds(const AABB &box, mat4x4 const model) {
+    AABB result{};
+    for (int row = 0; row < 3; row++) {
+        result.min[row] = result.max[row] = model[3][row];
+        for (int column = 0; column < 3; column++) {
+            float a = model[column][row] * box.min[column];
+            float b = model[column][row] * box.max[column];
+            result.min[row] += fminf(a, b);
+            result.max[row] += fmaxf(a, b);
+        }
+    }
+    return result;
+}
+
+/* Gribb & Hartmann: with rows r0..r3 of the matrix, a point is inside when -w <= x, y, z <= w, so the planes
+ * are r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 */
+Frustum::Frustum(mat4x4 const viewProjection) {
+    for (int plane = 0; plane < 6; plane++) {
+        int row = plane / 2;
+        float sign = plane % 2 == 0 ? 1.f : -1.f;
+        for (int column = 0; column < 4; column++)
+            m_Planes[plane][column] = viewProjection[column][3] + sign * viewProjection[column][row];
+
+        float length = vec3_len(m_Planes[plane]);
+        if (length > 0.f)
+            vec4_scale(m_Planes[plane], m_Planes[plane], 1.f / length);
+    }
+}
+
+bool Frustum::intersects(const BoundingSphere &sphere) const {
+    for (const vec4 &plane: m_Planes) {
+        if (vec3_mul_inner(plane, sphere.center) + plane[3] < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const AABB &box) const {
+    for (const vec4 &plane: m_Planes) {
+        /* The corner furthest along the normal */
+        vec3 corner;
+        for (int axis = 0; axis < 3; axis++)
+            corner[axis] = plane[axis] >= 0.f ? box.max[axis] : box.min[axis];
+        if (vec3_mul_inner(plane, corner) + plane[3] < 0.f)
+            return false;
+    }
+    return true;
+}
+
+Containment Frustum::classify(const AABB &box) const {
+    Containment result = Containment::INSIDE;
+    for (const vec4 &plane: m_Planes) {
+        vec3 furthest, nearest;
+        for (int axis = 0; axis < 3; axis++) {
+            furthest[axis] = plane[axis] >= 0.f ? box.max[axis] : box.min[axis];
+            nearest[axis] = plane[axis] >= 0.f ? box.min[axis] : box.max[axis];
+        }
+        if (vec3_mul_inner(plane, furthest) + plane[3] < 0.f)
+            return Containment::OUTSIDE;
+        if (vec3_mul_inner(plane, nearest) + plane[3] < 0.f)
+            result = Containment::INTERSECTING;
+    }
+    return result;
+}
+
+/* Lanes of [visibleLanes] that are set, as indices from [first] */
+static size_t emitVisible(int visibleLanes, size_t first, uint32_t *visible) {
+    size_t written = 0;
+    while (visibleLanes) {
+        visible[written++] = (uint32_t) (first + __builtin_ctz(visibleLanes));
+        visibleLanes &= visibleLanes - 1;
+    }
+    return written;
+}
+
+size_t Frustum::cull(const BoundingSphere *bounds, size_t count, uint32_t *visible) const {
+    float4 planes[6][4];
+    for (int plane = 0; plane < 6; plane++) {
+        for (int component = 0; component < 4; component++)
+            planes[plane][component] = broadcast4(m_Planes[plane][component]);
+    }
+
+    size_t written = 0;
+    for (size_t first = 0; first < count; first += 4) {
+        size_t lanes = count - first < 4 ? count - first : 4;
+        BoundingSphere padded[4] = {};
+        const BoundingSphere *group = bounds + first;
+        if (lanes < 4) {
+            for (size_t lane = 0; lane < lanes; lane++)
+                padded[lane] = group[lane];
+            group = padded;
+        }
+
+        /* One sphere per lane: x, y, z and radius of four spheres */
+        float4 x = load4(group[0].center), y = load4(group[1].center);
+        float4 z = load4(group[2].center), radius = load4(group[3].center);
+        transpose4(x, y, z, radius);
+
+        /* Smallest signed distance to any plane, offset by the radius: negative means fully outside one */
+        float4 nearest = broadcast4(INFINITY);
+        for (const float4 *plane: planes) {
+            float4 distance = madd4(plane[0], x, madd4(plane[1], y, madd4(plane[2], z, plane[3])));
+            nearest = min4(nearest, add4(distance, radius));
+        }
+        int visibleLanes = ~lessMask4(nearest, broadcast4(0.f)) & ((1 << lanes) - 1);
+        written += emitVisible(visibleLanes, first, visible + written);
+    }
+    return written;
+}
+
+size_t Frustum::cull(const AABB *bounds, size_t count, uint32_t *visible) const {
+    size_t written = 0;
+    for (size_t first = 0; first < count; first += 4) {
+        size_t lanes = count - first < 4 ? count - first : 4;
+        AABB padded[4] = {};
+        const AABB *group = bounds + first;
+        if (lanes < 4) {
+            for (size_t lane = 0; lane < lanes; lane++)
+                padded[lane] = group[lane];
+            group = padded;
+        }
+
+        /* A box is six floats; two overlapping loads per box cover them without reading past it */
+        float4 minX = load4(group[0].min), minY = load4(group[1].min);
+        float4 minZ = load4(group[2].min), firstMaxX = load4(group[3].min);
+        transpose4(minX, minY, minZ, firstMaxX);
+        float4 lastMinZ = load4(&group[0].min[2]), maxX = load4(&group[1].min[2]);
+        float4 maxY = load4(&group[2].min[2]), maxZ = load4(&group[3].min[2]);
+        transpose4(lastMinZ, maxX, maxY, maxZ);
+
+        int outside = 0;
+        for (const vec4 &plane: m_Planes) {
+            /* The normal's signs are the same in every lane, so the furthest corner is a per-plane choice */
+            float4 distance = broadcast4(plane[3]);
+            distance = madd4(broadcast4(plane[0]), plane[0] >= 0.f ? maxX : minX, distance);
+            distance = madd4(broadcast4(plane[1]), plane[1] >= 0.f ? maxY : minY, distance);
+            distance = madd4(broadcast4(plane[2]), plane[2] >= 0.f ? maxZ : minZ, distance);
+            outside |= lessMask4(distance, broadcast4(0.f));
+        }
+        int visibleLanes = ~outside & ((1 << lanes) - 1);
+        written += emitVisible(visibleLanes, first, visible + written);
+    }
+    return written;
+}
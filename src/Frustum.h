@@ -0,0 +1,52 @@
+#ifndef OPENGL_FRUSTUM_H
+#define OPENGL_FRUSTUM_H
+
+#include <cstddef>
+#include <cstdint>
+#include "linmath.h"
+
+/* Laid out as four floats so the culling loop can load one per SIMD register */
+struct BoundingSphere {
+    vec3 center;
+    float radius;
+};
+
+struct AABB {
+    vec3 min;
+    vec3 max;
+};
+
+BoundingSphere makeBoundingSphere(const AABB &box);
+/* Object-space bounds moved into the space of [model]; a sphere's radius grows by the largest axis scale */
+BoundingSphere transformBounds(const BoundingSphere &sphere, mat4x4 const model);
+AABB transformBounds(const AABB &box, mat4x4 const model);
+
+enum class Containment {
+    OUTSIDE, INTERSECTING, INSIDE
+};
+
+/* The six clip planes of a view-projection matrix, e.g. projection from mat4x4_perspective or mat4x4_ortho
+ * times a view matrix, in the space the matrix maps from (world space for a view-projection) */
+class Frustum {
+private:
+    /* (normal, distance) with unit normals pointing inwards: left, right, bottom, top, near, far */
+    vec4 m_Planes[6];
+
+public:
+    explicit Frustum(mat4x4 const viewProjection);
+
+    /* Conservative: bounds that straddle two planes outside a corner may still pass */
+    [[nodiscard]] bool intersects(const BoundingSphere &sphere) const;
+    [[nodiscard]] bool intersects(const AABB &box) const;
+    /* Also tells boxes wholly inside apart, whose contents need no further tests */
+    [[nodiscard]] Containment classify(const AABB &box) const;
+
+    /* Tests four bounds per iteration and writes the indices of those that may be visible, in ascending order,
+     * to [visible], which needs room for [count]. Returns how many were written */
+    size_t cull(const BoundingSphere *bounds, size_t count, uint32_t *visible) const;
+    size_t cull(const AABB *bounds, size_t count, uint32_t *visible) const;
+
+    inline const vec4 &getPlane(unsigned int index) const { return m_Planes[index]; }
+};
+
+#endif //OPENGL_FRUSTUM_H
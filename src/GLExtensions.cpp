@@ -0,0 +1,117 @@
+#include <cstring>
+#include "GLExtensions.h"
+
+#ifdef OPENGL_EXT_ARB_get_program_binary
+int GLAD_GL_ARB_get_program_binary = 0;
+PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glad_glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_KHR_parallel_shader_compile
+int GLAD_GL_KHR_parallel_shader_compile = 0;
+PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_buffer_storage
+int GLAD_GL_ARB_buffer_storage = 0;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_draw_indirect
+int GLAD_GL_ARB_draw_indirect = 0;
+PFNGLDRAWELEMENTSINDIRECTPROC glad_glDrawElementsIndirect = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_base_instance
+int GLAD_GL_ARB_base_instance = 0;
+PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC glad_glDrawElementsInstancedBaseVertexBaseInstance = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_multi_draw_indirect
+int GLAD_GL_ARB_multi_draw_indirect = 0;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_vertex_attrib_binding
+int GLAD_GL_ARB_vertex_attrib_binding = 0;
+PFNGLBINDVERTEXBUFFERPROC glad_glBindVertexBuffer = nullptr;
+PFNGLVERTEXATTRIBFORMATPROC glad_glVertexAttribFormat = nullptr;
+PFNGLVERTEXATTRIBBINDINGPROC glad_glVertexAttribBinding = nullptr;
+PFNGLVERTEXBINDINGDIVISORPROC glad_glVertexBindingDivisor = nullptr;
+#endif
+
+static bool hasExtension(const char *name) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        if (strcmp((const char *) glGetStringi(GL_EXTENSIONS, i), name) == 0)
+            return true;
+    }
+    return false;
+}
+
+/* True when the context version is at least major.minor, i.e. the feature is core */
+static bool hasVersion(int major, int minor) {
+    int contextMajor = 0, contextMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+void loadGLExtensions(GLADloadfunc load) {
+#ifdef OPENGL_EXT_ARB_get_program_binary
+    GLAD_GL_ARB_get_program_binary = hasVersion(4, 1) || hasExtension("GL_ARB_get_program_binary");
+    if (GLAD_GL_ARB_get_program_binary) {
+        glad_glGetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) load("glGetProgramBinary");
+        glad_glProgramBinary = (PFNGLPROGRAMBINARYPROC) load("glProgramBinary");
+        glad_glProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) load("glProgramParameteri");
+        GLAD_GL_ARB_get_program_binary = glad_glGetProgramBinary && glad_glProgramBinary && glad_glProgramParameteri;
+    }
+#endif
+
+#ifdef OPENGL_EXT_KHR_parallel_shader_compile
+    if (hasExtension("GL_KHR_parallel_shader_compile"))
+        glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsKHR");
+    else if (hasExtension("GL_ARB_parallel_shader_compile"))
+        glad_glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC) load("glMaxShaderCompilerThreadsARB");
+    GLAD_GL_KHR_parallel_shader_compile = glad_glMaxShaderCompilerThreadsKHR != nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_buffer_storage
+    if (hasVersion(4, 4) || hasExtension("GL_ARB_buffer_storage"))
+        glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC) load("glBufferStorage");
+    GLAD_GL_ARB_buffer_storage = glad_glBufferStorage != nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_draw_indirect
+    if (hasVersion(4, 0) || hasExtension("GL_ARB_draw_indirect"))
+        glad_glDrawElementsIndirect = (PFNGLDRAWELEMENTSINDIRECTPROC) load("glDrawElementsIndirect");
+    GLAD_GL_ARB_draw_indirect = glad_glDrawElementsIndirect != nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_base_instance
+    if (hasVersion(4, 2) || hasExtension("GL_ARB_base_instance"))
+        glad_glDrawElementsInstancedBaseVertexBaseInstance = (PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)
+                load("glDrawElementsInstancedBaseVertexBaseInstance");
+    GLAD_GL_ARB_base_instance = glad_glDrawElementsInstancedBaseVertexBaseInstance != nullptr;
+#endif
+
+#ifdef OPENGL_EXT_ARB_multi_draw_indirect
+    if (hasVersion(4, 3) || hasExtension("GL_ARB_multi_draw_indirect"))
+        glad_glMultiDrawElementsIndirect = (PFNGLMULTIDRAWELEMENTSINDIRECTPROC) load("glMultiDrawElementsIndirect");
+    GLAD_GL_ARB_multi_draw_indirect = glad_glMultiDrawElementsIndirect != nullptr && GLAD_GL_ARB_draw_indirect;
+#endif
+
+#ifdef OPENGL_EXT_ARB_vertex_attrib_binding
+    GLAD_GL_ARB_vertex_attrib_binding = hasVersion(4, 3) || hasExtension("GL_ARB_vertex_attrib_binding");
+    if (GLAD_GL_ARB_vertex_attrib_binding) {
+        glad_glBindVertexBuffer = (PFNGLBINDVERTEXBUFFERPROC) load("glBindVertexBuffer");
+        glad_glVertexAttribFormat = (PFNGLVERTEXATTRIBFORMATPROC) load("glVertexAttribFormat");
+        glad_glVertexAttribBinding = (PFNGLVERTEXATTRIBBINDINGPROC) load("glVertexAttribBinding");
+        glad_glVertexBindingDivisor = (PFNGLVERTEXBINDINGDIVISORPROC) load("glVertexBindingDivisor");
+        GLAD_GL_ARB_vertex_attrib_binding = glad_glBindVertexBuffer && glad_glVertexAttribFormat &&
+                                            glad_glVertexAttribBinding && glad_glVertexBindingDivisor;
+    }
+#endif
+}
@@ -0,0 +1,123 @@
+#ifndef OPENGL_GLEXTENSIONS_H
+#define OPENGL_GLEXTENSIONS_H
+
+#ifndef GLAD_GL_H_ /* Only glad's declarations are include-guarded, a second include redefines the loader */
+#include "glad/gl.h"
+#endif
+
+/* The bundled glad loader only covers GL 3.3 core and KHR_debug. Entry points beyond that are declared
+ * here in glad's naming scheme and loaded by loadGLExtensions(); each block steps aside if glad is
+ * regenerated with the extension. The GLAD_GL_* flags are also set when the core version includes it */
+
+#ifndef GL_ARB_get_program_binary
+#define GL_ARB_get_program_binary 1
+#define OPENGL_EXT_ARB_get_program_binary
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+typedef void (GLAD_API_PTR *PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length,
+                                                       GLenum *binaryFormat, void *binary);
+typedef void (GLAD_API_PTR *PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary,
+                                                    GLsizei length);
+typedef void (GLAD_API_PTR *PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern int GLAD_GL_ARB_get_program_binary;
+extern PFNGLGETPROGRAMBINARYPROC glad_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC glad_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri;
+#define glGetProgramBinary glad_glGetProgramBinary
+#define glProgramBinary glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+#endif
+
+#ifndef GL_KHR_parallel_shader_compile
+#define GL_KHR_parallel_shader_compile 1
+#define OPENGL_EXT_KHR_parallel_shader_compile
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+typedef void (GLAD_API_PTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+extern int GLAD_GL_KHR_parallel_shader_compile; /* Also set for the identical ARB_parallel_shader_compile */
+extern PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glad_glMaxShaderCompilerThreadsKHR;
+#define glMaxShaderCompilerThreadsKHR glad_glMaxShaderCompilerThreadsKHR
+#endif
+
+#ifndef GL_ARB_buffer_storage
+#define GL_ARB_buffer_storage 1
+#define OPENGL_EXT_ARB_buffer_storage
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#define GL_BUFFER_IMMUTABLE_STORAGE 0x821F
+#define GL_BUFFER_STORAGE_FLAGS 0x8220
+typedef void (GLAD_API_PTR *PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern int GLAD_GL_ARB_buffer_storage;
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+#ifndef GL_ARB_draw_indirect
+#define GL_ARB_draw_indirect 1
+#define OPENGL_EXT_ARB_draw_indirect
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_DRAW_INDIRECT_BUFFER_BINDING 0x8F43
+typedef void (GLAD_API_PTR *PFNGLDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect);
+extern int GLAD_GL_ARB_draw_indirect;
+extern PFNGLDRAWELEMENTSINDIRECTPROC glad_glDrawElementsIndirect;
+#define glDrawElementsIndirect glad_glDrawElementsIndirect
+#endif
+
+#ifndef GL_ARB_base_instance
+#define GL_ARB_base_instance 1
+#define OPENGL_EXT_ARB_base_instance
+typedef void (GLAD_API_PTR *PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)(GLenum mode, GLsizei count,
+                                                                                 GLenum type, const void *indices,
+                                                                                 GLsizei instancecount,
+                                                                                 GLint basevertex,
+                                                                                 GLuint baseinstance);
+extern int GLAD_GL_ARB_base_instance; /* Also what lets indirect commands carry a non-zero baseInstance */
+extern PFNGLDRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC glad_glDrawElementsInstancedBaseVertexBaseInstance;
+#define glDrawElementsInstancedBaseVertexBaseInstance glad_glDrawElementsInstancedBaseVertexBaseInstance
+#endif
+
+#ifndef GL_ARB_multi_draw_indirect
+#define GL_ARB_multi_draw_indirect 1
+#define OPENGL_EXT_ARB_multi_draw_indirect
+typedef void (GLAD_API_PTR *PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect,
+                                                               GLsizei drawcount, GLsizei stride);
+extern int GLAD_GL_ARB_multi_draw_indirect;
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+#endif
+
+#ifndef GL_ARB_vertex_attrib_binding
+#define GL_ARB_vertex_attrib_binding 1
+#define OPENGL_EXT_ARB_vertex_attrib_binding
+#define GL_VERTEX_ATTRIB_BINDING 0x82D4
+#define GL_VERTEX_ATTRIB_RELATIVE_OFFSET 0x82D5
+#define GL_VERTEX_BINDING_DIVISOR 0x82D6
+#define GL_VERTEX_BINDING_OFFSET 0x82D7
+#define GL_VERTEX_BINDING_STRIDE 0x82D8
+#define GL_MAX_VERTEX_ATTRIB_RELATIVE_OFFSET 0x82D9
+#define GL_MAX_VERTEX_ATTRIB_BINDINGS 0x82DA
+typedef void (GLAD_API_PTR *PFNGLBINDVERTEXBUFFERPROC)(GLuint bindingindex, GLuint buffer, GLintptr offset,
+                                                       GLsizei stride);
+typedef void (GLAD_API_PTR *PFNGLVERTEXATTRIBFORMATPROC)(GLuint attribindex, GLint size, GLenum type,
+                                                         GLboolean normalized, GLuint relativeoffset);
+typedef void (GLAD_API_PTR *PFNGLVERTEXATTRIBBINDINGPROC)(GLuint attribindex, GLuint bindingindex);
+typedef void (GLAD_API_PTR *PFNGLVERTEXBINDINGDIVISORPROC)(GLuint bindingindex, GLuint divisor);
+extern int GLAD_GL_ARB_vertex_attrib_binding;
+extern PFNGLBINDVERTEXBUFFERPROC glad_glBindVertexBuffer;
+extern PFNGLVERTEXATTRIBFORMATPROC glad_glVertexAttribFormat;
+extern PFNGLVERTEXATTRIBBINDINGPROC glad_glVertexAttribBinding;
+extern PFNGLVERTEXBINDINGDIVISORPROC glad_glVertexBindingDivisor;
+#define glBindVertexBuffer glad_glBindVertexBuffer
+#define glVertexAttribFormat glad_glVertexAttribFormat
+#define glVertexAttribBinding glad_glVertexAttribBinding
+#define glVertexBindingDivisor glad_glVertexBindingDivisor
+#endif
+
+/* Call after gladLoadGL() with the same loader, while the context is current */
+void loadGLExtensions(GLADloadfunc load);
+
+#endif //OPENGL_GLEXTENSIONS_H
@@ -0,0 +1,108 @@
+#include "GLState.h"
+#include "Renderer.h"
+
+GLState &GLState::get() {
+    /* GL allows one current context per thread, so one shadow per thread tracks it */
+    thread_local GLState state;
+    return state;
+}
+
+void GLState::useProgram(unsigned int program) {
+    if (m_Program == program) {
+        m_SkippedCalls++;
+        return;
+    }
+    GLCall(glUseProgram(program));
+    m_Program = program;
+    m_IssuedCalls++;
+}
+
+void GLState::bindVertexArray(unsigned int vertexArray) {
+    if (m_VertexArray == vertexArray) {
+        m_SkippedCalls++;
+        return;
+    }
+    GLCall(glBindVertexArray(vertexArray));
+    m_VertexArray = vertexArray;
+    m_ElementArrayBuffer = UNKNOWN; /* The newly bound VAO carries its own element buffer binding */
+    m_IssuedCalls++;
+}
+
+void GLState::bindBuffer(unsigned int target, unsigned int buffer) {
+    unsigned int *shadow = nullptr;
+    switch (target) {
+        case GL_ARRAY_BUFFER:
+            shadow = &m_ArrayBuffer;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            shadow = &m_ElementArrayBuffer;
+            break;
+    }
+
+    if (shadow && *shadow == buffer) {
+        m_SkippedCalls++;
+        return;
+    }
+    GLCall(glBindBuffer(target, buffer));
+    if (shadow) *shadow = buffer;
+    m_IssuedCalls++;
+}
+
+void GLState::viewport(int x, int y, int width, int height) {
+    if (m_Viewport[0] == x && m_Viewport[1] == y && m_Viewport[2] == width && m_Viewport[3] == height) {
+        m_SkippedCalls++;
+        return;
+    }
+    GLCall(glViewport(x, y, width, height));
+    m_Viewport[0] = x;
+    m_Viewport[1] = y;
+    m_Viewport[2] = width;
+    m_Viewport[3] = height;
+    m_IssuedCalls++;
+}
+
+void GLState::clearColor(float r, float g, float b, float a) {
+    if (m_ClearColorKnown &&
+        m_ClearColor[0] == r && m_ClearColor[1] == g && m_ClearColor[2] == b && m_ClearColor[3] == a) {
+        m_SkippedCalls++;
+        return;
+    }
+    GLCall(glClearColor(r, g, b, a));
+    m_ClearColor[0] = r;
+    m_ClearColor[1] = g;
+    m_ClearColor[2] = b;
+    m_ClearColor[3] = a;
+    m_ClearColorKnown = true;
+    m_IssuedCalls++;
+}
+
+void GLState::onDeleteProgram(unsigned int program) {
+    /* A deleted program stays in use until another one is installed, so only forget it */
+    if (m_Program == program) m_Program = UNKNOWN;
+}
+
+void GLState::onDeleteVertexArray(unsigned int vertexArray) {
+    if (m_VertexArray == vertexArray) {
+        m_VertexArray = 0;
+        m_ElementArrayBuffer = UNKNOWN;
+    }
+}
+
+void GLState::onDeleteBuffer(unsigned int buffer) {
+    if (m_ArrayBuffer == buffer) m_ArrayBuffer = 0;
+    if (m_ElementArrayBuffer == buffer) m_ElementArrayBuffer = 0;
+}
+
+void GLState::invalidate() {
+    m_Program = UNKNOWN;
+    m_VertexArray = UNKNOWN;
+    m_ArrayBuffer = UNKNOWN;
+    m_ElementArrayBuffer = UNKNOWN;
+    for (int &value: m_Viewport) value = -1;
+    m_ClearColorKnown = false;
+}
+
+void GLState::resetCounters() {
+    m_IssuedCalls = 0;
+    m_SkippedCalls = 0;
+}
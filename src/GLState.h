@@ -0,0 +1,48 @@
+#ifndef OPENGL_GLSTATE_H
+#define OPENGL_GLSTATE_H
+
+#include <cstdint>
+
+/* Shadow copy of the bind/viewport/clear state of the context current on this thread.
+ * Wrapper classes route their GL state changes through here so calls that would not change
+ * anything are skipped. Raw GL calls that change the same state bypass the shadow: call
+ * invalidate() afterwards (and after switching contexts) to resynchronise */
+class GLState {
+private:
+    static constexpr unsigned int UNKNOWN = ~0u;
+
+    unsigned int m_Program = UNKNOWN;
+    unsigned int m_VertexArray = UNKNOWN;
+    unsigned int m_ArrayBuffer = UNKNOWN;
+    unsigned int m_ElementArrayBuffer = UNKNOWN; /* Belongs to the bound VAO */
+    int m_Viewport[4] = {-1, -1, -1, -1};
+    float m_ClearColor[4] = {-1.f, -1.f, -1.f, -1.f};
+    bool m_ClearColorKnown = false;
+
+    uint64_t m_IssuedCalls = 0;
+    uint64_t m_SkippedCalls = 0;
+
+    GLState() = default;
+
+public:
+    static GLState &get();
+
+    void useProgram(unsigned int program);
+    void bindVertexArray(unsigned int vertexArray);
+    void bindBuffer(unsigned int target, unsigned int buffer);
+    void viewport(int x, int y, int width, int height);
+    void clearColor(float r, float g, float b, float a);
+
+    /* Deleting a bound object implicitly rebinds 0, so the shadow has to follow */
+    void onDeleteProgram(unsigned int program);
+    void onDeleteVertexArray(unsigned int vertexArray);
+    void onDeleteBuffer(unsigned int buffer);
+
+    void invalidate();
+
+    inline uint64_t getIssuedCount() const { return m_IssuedCalls; }
+    inline uint64_t getSkippedCount() const { return m_SkippedCalls; }
+    void resetCounters();
+};
+
+#endif //OPENGL_GLSTATE_H
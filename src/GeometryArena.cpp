@@ -0,0 +1,38 @@
+#include "GeometryArena.h"
+#include "VertexBufferLayout.h"
+
+GeometryArena::GeometryArena(const VertexBufferLayout &layout, unsigned int vertexCapacity,
+                             unsigned int indexCapacity) :
+    m_Stride(layout.getStride()),
+    m_VertexBuffer(nullptr, vertexCapacity * layout.getStride()),
+    /* Indices are relative to each mesh's base vertex, so they never exceed the vertex capacity:
+     * arenas of up to 65536 vertices get 16-bit indices */
+    m_IndexBuffer(nullptr, indexCapacity, vertexCapacity ? vertexCapacity - 1 : 0),
+    m_VertexAllocator(vertexCapacity),
+    m_IndexAllocator(indexCapacity) {
+    m_VertexArray.addBuffer(m_VertexBuffer, layout);
+    m_IndexBuffer.bind(); /* Recorded in the VAO */
+    m_VertexArray.unBind();
+}
+
+std::optional<MeshRange> GeometryArena::allocate(const void *vertices, unsigned int vertexCount,
+                                                 const unsigned int *indices, unsigned int indexCount) {
+    unsigned int baseVertex = m_VertexAllocator.allocate(vertexCount);
+    if (baseVertex == FreeListAllocator::INVALID_OFFSET)
+        return std::nullopt;
+
+    unsigned int firstIndex = m_IndexAllocator.allocate(indexCount);
+    if (firstIndex == FreeListAllocator::INVALID_OFFSET) {
+        m_VertexAllocator.free(baseVertex, vertexCount);
+        return std::nullopt;
+    }
+
+    m_VertexBuffer.setSubData(baseVertex * m_Stride, vertices, vertexCount * m_Stride);
+    m_IndexBuffer.setSubData(firstIndex, indices, indexCount);
+    return MeshRange{baseVertex, vertexCount, firstIndex, indexCount};
+}
+
+void GeometryArena::free(const MeshRange &range) {
+    m_VertexAllocator.free(range.baseVertex, range.vertexCount);
+    m_IndexAllocator.free(range.firstIndex, range.indexCount);
+}
@@ -0,0 +1,44 @@
+#ifndef OPENGL_GEOMETRYARENA_H
+#define OPENGL_GEOMETRYARENA_H
+
+#include <optional>
+#include "FreeListAllocator.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+/* Where a mesh lives inside a GeometryArena. Indices are stored relative to the mesh's first vertex
+ * and drawn with baseVertex, so uploading a mesh never rewrites its indices */
+struct MeshRange {
+    unsigned int baseVertex;
+    unsigned int vertexCount;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+/* One large vertex buffer and one large index buffer shared by many meshes of the same vertex layout,
+ * with a single VAO over both. Meshes are sub-allocated from free lists, so drawing any of them only
+ * needs that one VAO bound plus glDrawElementsBaseVertex */
+class GeometryArena {
+private:
+    unsigned int m_Stride;
+    VertexBuffer m_VertexBuffer;
+    IndexBuffer m_IndexBuffer;
+    VertexArray m_VertexArray;
+    FreeListAllocator m_VertexAllocator; /* In vertices */
+    FreeListAllocator m_IndexAllocator;  /* In indices */
+
+public:
+    GeometryArena(const VertexBufferLayout &layout, unsigned int vertexCapacity, unsigned int indexCapacity);
+
+    /* Copies the mesh in; returns nothing when either buffer has no block large enough */
+    std::optional<MeshRange> allocate(const void *vertices, unsigned int vertexCount,
+                                      const unsigned int *indices, unsigned int indexCount);
+    void free(const MeshRange &range);
+
+    inline const VertexArray &getVertexArray() const { return m_VertexArray; }
+    inline const IndexBuffer &getIndexBuffer() const { return m_IndexBuffer; }
+    inline unsigned int getStride() const { return m_Stride; }
+};
+
+#endif //OPENGL_GEOMETRYARENA_H
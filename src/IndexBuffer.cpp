@@ -1,22 +1,88 @@
+#include <algorithm>
+#include <cstdint>
 #include "IndexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "VertexArrayCache.h"
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count) :
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, unsigned int maxIndex, bool allowByteIndices) :
     m_Count(count) {
+    if (data && maxIndex == ~0u)
+        maxIndex = count ? *std::max_element(data, data + count) : 0;
+
+    if (allowByteIndices && maxIndex <= UINT8_MAX) {
+        m_Type = GL_UNSIGNED_BYTE;
+        m_IndexSize = sizeof(uint8_t);
+    } else if (maxIndex <= UINT16_MAX) {
+        m_Type = GL_UNSIGNED_SHORT;
+        m_IndexSize = sizeof(uint16_t);
+    } else {
+        m_Type = GL_UNSIGNED_INT;
+        m_IndexSize = sizeof(uint32_t);
+    }
+
+    std::vector<unsigned char> narrowed;
+    const void *upload = data ? narrow(data, count, narrowed) : nullptr;
+
     GLCall(glGenBuffers(1, &m_RendererID)) ; /* Create for me a buffer */
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID)); /* Set buffer type */
+    GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID); /* Set buffer type */
     /* Creates and initializes a buffer object's data store */
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER , count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER , count * m_IndexSize, upload, GL_STATIC_DRAW));
+}
+
+IndexBuffer::IndexBuffer(unsigned int type, const void *data, unsigned int count) :
+    m_Count(count), m_Type(type) {
+    switch (type) {
+        case GL_UNSIGNED_BYTE:
+            m_IndexSize = sizeof(uint8_t);
+            break;
+        case GL_UNSIGNED_SHORT:
+            m_IndexSize = sizeof(uint16_t);
+            break;
+        default:
+            ASSERT(type == GL_UNSIGNED_INT);
+            m_IndexSize = sizeof(uint32_t);
+    }
+
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * m_IndexSize, data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer() {
+    VertexArrayCache::onDeleteBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::get().onDeleteBuffer(m_RendererID);
+}
+
+void IndexBuffer::setSubData(unsigned int firstIndex, const unsigned int *data, unsigned int count) {
+    std::vector<unsigned char> narrowed;
+    const void *upload = narrow(data, count, narrowed);
+
+    /* Not through GL_ELEMENT_ARRAY_BUFFER, which would attach this buffer to whatever VAO is bound */
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * m_IndexSize, count * m_IndexSize, upload));
+}
+
+const void *IndexBuffer::narrow(const unsigned int *data, unsigned int count,
+                                std::vector<unsigned char> &storage) const {
+    switch (m_Type) {
+        case GL_UNSIGNED_BYTE:
+            storage.assign(data, data + count);
+            return storage.data();
+        case GL_UNSIGNED_SHORT:
+            storage.resize(count * sizeof(uint16_t));
+            std::copy(data, data + count, (uint16_t *) storage.data());
+            return storage.data();
+        default:
+            return data;
+    }
 }
 
 void IndexBuffer::bind() const {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 }
 
 void IndexBuffer::unBind() const  {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0 ));
+    GLState::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
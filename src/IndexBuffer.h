@@ -1,18 +1,38 @@
 #ifndef OPENGL_INDEXBUFFER_H
 #define OPENGL_INDEXBUFFER_H
 
+#include <vector>
+
 class IndexBuffer {
 private:
     unsigned int m_RendererID;
     unsigned int m_Count;
+    unsigned int m_Type;      /* GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+    unsigned int m_IndexSize; /* In bytes */
 public:
-    IndexBuffer(const unsigned int* data, unsigned int count);
+    /* Indices are stored in the narrowest type that holds [maxIndex]; when it's left unknown it is found by
+     * scanning [data]. [data] may be nullptr to only reserve storage, filled later with setSubData.
+     * 8-bit indices are opt-in: several GPUs widen them on the fly, costing more than the bandwidth saved */
+    IndexBuffer(const unsigned int* data, unsigned int count, unsigned int maxIndex = ~0u,
+                bool allowByteIndices = false);
+    /* Uploads [data] as is, already stored as [type] */
+    IndexBuffer(unsigned int type, const void* data, unsigned int count);
     ~IndexBuffer();
 
+    /* Narrows [data] to the buffer's type; every index must fit it */
+    void setSubData(unsigned int firstIndex, const unsigned int* data, unsigned int count);
+
     void bind() const;
     void unBind() const;
 
     inline unsigned int getCount() const { return m_Count;  }
+    inline unsigned int getRendererID() const { return m_RendererID; }
+    inline unsigned int getType() const { return m_Type; }
+    inline unsigned int getIndexSize() const { return m_IndexSize; }
+
+private:
+    /* Returns [data] converted to m_Type, or [data] itself when no conversion is needed */
+    const void *narrow(const unsigned int* data, unsigned int count, std::vector<unsigned char>& storage) const;
 };
 
 #endif //OPENGL_INDEXBUFFER_H
@@ -0,0 +1,187 @@
+#include "LinmathSIMD.h"
+#include "Float4.h"
+
+/* Column c of a * b is a's columns weighted by the entries of b's column c. Each output column is written
+ * only after its input column is read, and a is loaded up front, so M may alias either input */
+static void mulArrayGeneric(mat4x4 *M, mat4x4 const a, const mat4x4 *b, size_t count) {
+    float4 a0 = load4(a[0]), a1 = load4(a[1]), a2 = load4(a[2]), a3 = load4(a[3]);
+    for (size_t i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c++) {
+            float4 column = load4(b[i][c]);
+            float4 result = mul4(a0, splat4<0>(column));
+            result = madd4(a1, splat4<1>(column), result);
+            result = madd4(a2, splat4<2>(column), result);
+            result = madd4(a3, splat4<3>(column), result);
+            store4(M[i][c], result);
+        }
+    }
+}
+
+static void mulGeneric(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+    mulArrayGeneric((mat4x4 *) M, a, (const mat4x4 *) b, 1);
+}
+
+#ifdef OPENGL_SIMD_SSE2
+/* Two output columns per 256-bit register: a's columns are duplicated into both lanes and the in-lane
+ * permutes pick the matching entry of each of b's two columns */
+__attribute__((target("avx2,fma")))
+static void mulArrayAVX2(mat4x4 *M, mat4x4 const a, const mat4x4 *b, size_t count) {
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *) a[0]);
+    __m256 a1 = _mm256_broadcast_ps((const __m128 *) a[1]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128 *) a[2]);
+    __m256 a3 = _mm256_broadcast_ps((const __m128 *) a[3]);
+    for (size_t i = 0; i < count; i++) {
+        for (int c = 0; c < 4; c += 2) {
+            __m256 columns = _mm256_loadu_ps(b[i][c]);
+            __m256 result = _mm256_mul_ps(a0, _mm256_permute_ps(columns, 0x00));
+            result = _mm256_fmadd_ps(a1, _mm256_permute_ps(columns, 0x55), result);
+            result = _mm256_fmadd_ps(a2, _mm256_permute_ps(columns, 0xAA), result);
+            result = _mm256_fmadd_ps(a3, _mm256_permute_ps(columns, 0xFF), result);
+            _mm256_storeu_ps(M[i][c], result);
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void mulAVX2(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+    mulArrayAVX2((mat4x4 *) M, a, (const mat4x4 *) b, 1);
+}
+#endif
+
+struct Kernels {
+    void (*mul)(mat4x4 M, mat4x4 const a, mat4x4 const b);
+    void (*mulArray)(mat4x4 *M, mat4x4 const a, const mat4x4 *b, size_t count);
+    const char *name;
+};
+
+static const Kernels &kernels() {
+    static const Kernels selected = [] {
+#if defined(OPENGL_SIMD_SSE2)
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return Kernels{mulAVX2, mulArrayAVX2, "AVX2+FMA"};
+        return Kernels{mulGeneric, mulArrayGeneric, "SSE2"};
+#elif defined(OPENGL_SIMD_NEON)
+        return Kernels{mulGeneric, mulArrayGeneric, "NEON"};
+#else
+        return Kernels{mulGeneric, mulArrayGeneric, "scalar"};
+#endif
+    }();
+    return selected;
+}
+
+void simd::mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b) {
+    kernels().mul(M, a, b);
+}
+
+void simd::mat4x4_mul_array(mat4x4 *M, mat4x4 const a, const mat4x4 *b, size_t count) {
+    kernels().mulArray(M, a, b, count);
+}
+
+const char *simd::getImplementation() {
+    return kernels().name;
+}
+
+void simd::mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v) {
+    float4 x = load4(v);
+    float4 result = mul4(load4(M[0]), splat4<0>(x));
+    result = madd4(load4(M[1]), splat4<1>(x), result);
+    result = madd4(load4(M[2]), splat4<2>(x), result);
+    result = madd4(load4(M[3]), splat4<3>(x), result);
+    store4(r, result);
+}
+
+/* Hamilton product with quaternions stored (x, y, z, w): each component of p scales a signed
+ * permutation of q */
+void simd::quat_mul(quat r, quat const p, quat const q) {
+    float4 P = load4(p), Q = load4(q);
+    float4 result = mul4(splat4<3>(P), Q);
+    result = madd4(splat4<0>(P), mul4(swizzle4<3, 2, 1, 0>(Q), set4(1.f, -1.f, 1.f, -1.f)), result);
+    result = madd4(splat4<1>(P), mul4(swizzle4<2, 3, 0, 1>(Q), set4(1.f, 1.f, -1.f, -1.f)), result);
+    result = madd4(splat4<2>(P), mul4(swizzle4<1, 0, 3, 2>(Q), set4(-1.f, 1.f, 1.f, -1.f)), result);
+    store4(r, result);
+}
+
+/* Each column is linmath's unnormalised rotation written as q's components weighting signed permutations
+ * of q, e.g. column 0 = x (x, y, z) + w (w, z, -y) + y (-y, x, -w) + z (-z, w, x). The same three
+ * permutations serve all columns; zeroing their last lane zeroes the columns' last row */
+void simd::mat4x4_from_quat(mat4x4 M, quat const q) {
+    float4 Q = load4(q);
+    float4 xyz = mul4(Q, set4(1.f, 1.f, 1.f, 0.f));
+    float4 A = mul4(swizzle4<3, 2, 1, 0>(Q), set4(1.f, 1.f, -1.f, 0.f));
+    float4 B = mul4(swizzle4<1, 0, 3, 0>(Q), set4(-1.f, 1.f, -1.f, 0.f));
+    float4 C = mul4(swizzle4<2, 3, 0, 0>(Q), set4(-1.f, 1.f, 1.f, 0.f));
+    float4 x = splat4<0>(Q), y = splat4<1>(Q), z = splat4<2>(Q), w = splat4<3>(Q);
+
+    store4(M[0], madd4(x, xyz, madd4(w, A, madd4(y, B, mul4(z, C)))));
+    store4(M[1], sub4(madd4(y, xyz, mul4(w, C)), madd4(x, B, mul4(z, A))));
+    store4(M[2], sub4(madd4(z, xyz, mul4(y, A)), madd4(w, B, mul4(x, C))));
+    store4(M[3], set4(0.f, 0.f, 0.f, 1.f));
+}
+
+#ifdef OPENGL_SIMD_SSE2
+/* 2x2 blocks held as (m00, m01, m10, m11): product, adjugate(a) * b and a * adjugate(b) */
+static inline __m128 mat2Mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, swizzle4<0, 3, 0, 3>(b)),
+                      _mm_mul_ps(swizzle4<1, 0, 3, 2>(a), swizzle4<2, 1, 2, 1>(b)));
+}
+
+static inline __m128 mat2AdjMul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(swizzle4<3, 3, 0, 0>(a), b),
+                      _mm_mul_ps(swizzle4<1, 1, 2, 2>(a), swizzle4<2, 3, 0, 1>(b)));
+}
+
+static inline __m128 mat2MulAdj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, swizzle4<3, 0, 3, 0>(b)),
+                      _mm_mul_ps(swizzle4<1, 0, 3, 2>(a), swizzle4<2, 1, 2, 1>(b)));
+}
+
+/* Block-wise inverse: with M = [A B; C D] in 2x2 blocks the inverse's blocks follow from the blocks'
+ * adjugates and determinants. The inverse of the transpose is the transpose of the inverse, so the rows
+ * of the derivation can be linmath's columns unchanged */
+void simd::mat4x4_invert(mat4x4 T, mat4x4 const M) {
+    __m128 m0 = load4(M[0]), m1 = load4(M[1]), m2 = load4(M[2]), m3 = load4(M[3]);
+
+    __m128 A = _mm_movelh_ps(m0, m1);
+    __m128 B = _mm_movehl_ps(m1, m0);
+    __m128 C = _mm_movelh_ps(m2, m3);
+    __m128 D = _mm_movehl_ps(m3, m2);
+
+    /* (|A|, |B|, |C|, |D|) */
+    __m128 determinants = _mm_sub_ps(
+            _mm_mul_ps(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(m1, m3, _MM_SHUFFLE(3, 1, 3, 1))),
+            _mm_mul_ps(_mm_shuffle_ps(m0, m2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(m1, m3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = splat4<0>(determinants), detB = splat4<1>(determinants);
+    __m128 detC = splat4<2>(determinants), detD = splat4<3>(determinants);
+
+    __m128 adjDC = mat2AdjMul(D, C);
+    __m128 adjAB = mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), mat2Mul(B, adjDC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), mat2Mul(C, adjAB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), mat2MulAdj(D, adjAB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), mat2MulAdj(A, adjDC));
+
+    /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */
+    __m128 trace = _mm_mul_ps(adjAB, swizzle4<0, 2, 1, 3>(adjDC));
+    trace = _mm_add_ps(trace, swizzle4<2, 3, 0, 1>(trace));
+    trace = _mm_add_ps(trace, swizzle4<1, 0, 3, 2>(trace));
+    __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+    __m128 inverseDet = _mm_div_ps(set4(1.f, -1.f, -1.f, 1.f), det);
+    X = _mm_mul_ps(X, inverseDet);
+    Y = _mm_mul_ps(Y, inverseDet);
+    Z = _mm_mul_ps(Z, inverseDet);
+    W = _mm_mul_ps(W, inverseDet);
+
+    /* The blocks computed above are adjugates; their final shuffle is folded into the store */
+    store4(T[0], _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+    store4(T[1], _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+    store4(T[2], _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+    store4(T[3], _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+}
+#else
+void simd::mat4x4_invert(mat4x4 T, mat4x4 const M) {
+    mat4x4 copy; /* linmath's version reads M after writing T */
+    ::mat4x4_dup(copy, M);
+    ::mat4x4_invert(T, copy);
+}
+#endif
@@ -0,0 +1,25 @@
+#ifndef OPENGL_LINMATHSIMD_H
+#define OPENGL_LINMATHSIMD_H
+
+#include <cstddef>
+#include "linmath.h"
+
+/* Vectorised versions of linmath functions with the same arguments and results, including outputs that
+ * alias an input. The implementation is picked once at startup: AVX2+FMA when the CPU has it, otherwise
+ * SSE2 on x86-64, NEON on AArch64, or plain scalar code */
+namespace simd {
+    void mat4x4_mul(mat4x4 M, mat4x4 const a, mat4x4 const b);
+    void mat4x4_mul_vec4(vec4 r, mat4x4 const M, vec4 const v);
+    /* Like linmath, assumes M is invertible */
+    void mat4x4_invert(mat4x4 T, mat4x4 const M);
+    void quat_mul(quat r, quat const p, quat const q);
+    void mat4x4_from_quat(mat4x4 M, quat const q);
+
+    /* M[i] = a * b[i] for [count] matrices; the batch form keeps a in registers across the loop */
+    void mat4x4_mul_array(mat4x4 *M, mat4x4 const a, const mat4x4 *b, size_t count);
+
+    /* Name of the selected implementation, for logs */
+    const char *getImplementation();
+}
+
+#endif //OPENGL_LINMATHSIMD_H
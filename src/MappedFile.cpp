@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        std::cout << "Warning: couldn't open " << path << std::endl;
+        return;
+    }
+
+    struct stat status{};
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void *data = mmap(nullptr, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data != MAP_FAILED) {
+            m_Data = data;
+            m_Size = (size_t) status.st_size;
+            /* Mapped files are mostly read front to back, so ask for aggressive read-ahead */
+            madvise(m_Data, m_Size, MADV_SEQUENTIAL);
+        }
+    }
+    /* The mapping keeps the file alive on its own */
+    ::close(descriptor);
+
+    if (!m_Data)
+        std::cout << "Warning: couldn't map " << path << std::endl;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept :
+    m_Data(std::exchange(other.m_Data, nullptr)), m_Size(std::exchange(other.m_Size, 0)) {
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+    }
+    return *this;
+}
+
+void MappedFile::prefetch(size_t offset, size_t size) const {
+    if (!m_Data || offset >= m_Size)
+        return;
+
+    /* madvise wants a page-aligned start */
+    auto pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size_t start = offset / pageSize * pageSize;
+    size_t end = std::min(offset + size, m_Size);
+    madvise((char *) m_Data + start, end - start, MADV_WILLNEED);
+}
+
+void MappedFile::close() {
+    if (m_Data)
+        munmap(m_Data, m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef OPENGL_MAPPEDFILE_H
+#define OPENGL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <filesystem>
+
+/* A whole file mapped read-only into memory. Pages are read in by the kernel on first touch, so handing
+ * getData() to glBufferData or memcpy streams the file without a separate read into a heap buffer */
+class MappedFile {
+private:
+    void *m_Data = nullptr;
+    size_t m_Size = 0;
+
+public:
+    MappedFile() = default;
+    /* Leaves the file closed, with a warning, if it can't be opened or is empty */
+    explicit MappedFile(const std::filesystem::path &path);
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /* Hints that [size] bytes from [offset] are about to be read, so the kernel starts reading them ahead */
+    void prefetch(size_t offset, size_t size) const;
+
+    inline bool isOpen() const { return m_Data != nullptr; }
+    inline const unsigned char *getData() const { return (const unsigned char *) m_Data; }
+    inline size_t getSize() const { return m_Size; }
+
+private:
+    void close();
+};
+
+#endif //OPENGL_MAPPEDFILE_H
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include "MeshFile.h"
+#include "Renderer.h"
+
+static_assert(sizeof(MeshRange) == 4 * sizeof(uint32_t), "MeshRange is stored in mesh files as is");
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT;
+}
+
+static unsigned int indexSizeOf(uint32_t type) {
+    return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+/* Bytes an attribute takes in the vertex, or 0 for one VertexBufferLayout couldn't have produced */
+static uint64_t attributeSize(const MeshFileAttribute &attribute) {
+    switch (attribute.type) {
+        case GL_FLOAT:
+        case GL_UNSIGNED_INT:
+        case GL_UNSIGNED_BYTE:
+        case GL_HALF_FLOAT:
+        case GL_SHORT:
+        case GL_BYTE:
+        case GL_INT_2_10_10_10_REV:
+            /* A packed vector always has all four components */
+            if (attribute.count < 1 || attribute.count > 4 ||
+                (attribute.type == GL_INT_2_10_10_10_REV && attribute.count != 4))
+                return 0;
+            return VertexBufferElement::getSize(attribute.type, attribute.count);
+        default:
+            return 0;
+    }
+}
+
+bool writeMeshFile(const std::filesystem::path &path, const VertexBufferLayout &layout, const void *vertices,
+                   unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+                   const std::vector<MeshRange> &meshes) {
+    unsigned int maxIndex = indexCount ? *std::max_element(indices, indices + indexCount) : 0;
+
+    std::vector<MeshFileAttribute> attributes;
+    for (const VertexBufferElement &element: layout.GetElement())
+        attributes.push_back({element.type, element.count, element.normalised, element.location, element.divisor,
+                              element.offset});
+    std::vector<MeshRange> ranges = meshes;
+    if (ranges.empty())
+        ranges.push_back({0, vertexCount, 0, indexCount});
+
+    MeshFileHeader header{};
+    std::copy(std::begin(MESH_FILE_MAGIC), std::end(MESH_FILE_MAGIC), header.magic);
+    header.version = MESH_FILE_VERSION;
+    header.attributeCount = (uint32_t) attributes.size();
+    header.meshCount = (uint32_t) ranges.size();
+    header.vertexCount = vertexCount;
+    header.vertexStride = layout.getStride();
+    header.indexCount = indexCount;
+    header.indexType = maxIndex <= UINT16_MAX ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    uint64_t tablesEnd = sizeof(header) + attributes.size() * sizeof(MeshFileAttribute) +
+                         ranges.size() * sizeof(MeshRange);
+    uint64_t vertexSize = (uint64_t) vertexCount * header.vertexStride;
+    header.vertexOffset = alignUp(tablesEnd);
+    header.indexOffset = alignUp(header.vertexOffset + vertexSize);
+
+    std::vector<uint16_t> shortIndices;
+    const void *indexData = indices;
+    if (header.indexType == GL_UNSIGNED_SHORT) {
+        shortIndices.assign(indices, indices + indexCount);
+        indexData = shortIndices.data();
+    }
+
+    const char padding[MESH_FILE_ALIGNMENT] = {};
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        stream.write((const char *) &header, sizeof(header));
+        stream.write((const char *) attributes.data(),
+                     (std::streamsize) (attributes.size() * sizeof(MeshFileAttribute)));
+        stream.write((const char *) ranges.data(), (std::streamsize) (ranges.size() * sizeof(MeshRange)));
+        stream.write(padding, (std::streamsize) (header.vertexOffset - tablesEnd));
+        stream.write((const char *) vertices, (std::streamsize) vertexSize);
+        stream.write(padding, (std::streamsize) (header.indexOffset - header.vertexOffset - vertexSize));
+        stream.write((const char *) indexData, (std::streamsize) indexCount * indexSizeOf(header.indexType));
+        if (!stream) {
+            std::cout << "Warning: couldn't write mesh file " << temporary << std::endl;
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::cout << "Warning: couldn't write mesh file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+MeshFile::MeshFile(const std::filesystem::path &path) : m_File(path) {
+    if (!m_File.isOpen())
+        return;
+
+    m_Header = (const MeshFileHeader *) m_File.getData();
+    if (!validate()) {
+        std::cout << "Warning: " << path << " is not a version " << MESH_FILE_VERSION << " mesh file" << std::endl;
+        m_Header = nullptr;
+        return;
+    }
+
+    auto *attributes = (const MeshFileAttribute *) (m_File.getData() + sizeof(MeshFileHeader));
+    std::vector<VertexBufferElement> elements;
+    for (uint32_t i = 0; i < m_Header->attributeCount; i++) {
+        const MeshFileAttribute &attribute = attributes[i];
+        auto normalised = (unsigned char) (attribute.normalised ? GL_TRUE : GL_FALSE);
+        elements.push_back({attribute.type, attribute.count, normalised, attribute.location, attribute.divisor,
+                            attribute.offset});
+    }
+    m_Layout = VertexBufferLayout(std::move(elements), m_Header->vertexStride);
+
+    /* Everything but the tables is read once, by the driver's copy, so have the kernel start on it now */
+    m_File.prefetch(m_Header->vertexOffset, m_File.getSize() - m_Header->vertexOffset);
+}
+
+std::span<const MeshRange> MeshFile::getMeshes() const {
+    auto *meshes = (const MeshRange *) (m_File.getData() + sizeof(MeshFileHeader) +
+                                        m_Header->attributeCount * sizeof(MeshFileAttribute));
+    return {meshes, m_Header->meshCount};
+}
+
+unsigned int MeshFile::getIndexDataSize() const {
+    return m_Header->indexCount * indexSizeOf(m_Header->indexType);
+}
+
+/* Sizes are checked in 64 bits, and against what VertexBuffer and IndexBuffer can take, so a corrupt
+ * header can't make any getter point outside the mapping */
+bool MeshFile::validate() const {
+    uint64_t fileSize = m_File.getSize();
+    if (fileSize < sizeof(MeshFileHeader) ||
+        std::string_view(m_Header->magic, 4) != std::string_view(MESH_FILE_MAGIC, 4) ||
+        m_Header->version != MESH_FILE_VERSION ||
+        (m_Header->indexType != GL_UNSIGNED_SHORT && m_Header->indexType != GL_UNSIGNED_INT))
+        return false;
+
+    uint64_t tablesEnd = sizeof(MeshFileHeader) + (uint64_t) m_Header->attributeCount * sizeof(MeshFileAttribute) +
+                         (uint64_t) m_Header->meshCount * sizeof(MeshRange);
+    uint64_t vertexSize = (uint64_t) m_Header->vertexCount * m_Header->vertexStride;
+    uint64_t indexSize = (uint64_t) m_Header->indexCount * indexSizeOf(m_Header->indexType);
+    if (tablesEnd > fileSize || vertexSize > UINT32_MAX || indexSize > UINT32_MAX ||
+        m_Header->vertexOffset % MESH_FILE_ALIGNMENT != 0 || m_Header->indexOffset % MESH_FILE_ALIGNMENT != 0 ||
+        m_Header->vertexOffset < tablesEnd || m_Header->vertexOffset > fileSize ||
+        vertexSize > fileSize - m_Header->vertexOffset || m_Header->indexOffset > fileSize ||
+        indexSize > fileSize - m_Header->indexOffset)
+        return false;
+
+    auto *attributes = (const MeshFileAttribute *) (m_File.getData() + sizeof(MeshFileHeader));
+    for (uint32_t i = 0; i < m_Header->attributeCount; i++) {
+        uint64_t size = attributeSize(attributes[i]);
+        if (size == 0 || attributes[i].offset + size > m_Header->vertexStride)
+            return false;
+    }
+
+    for (const MeshRange &mesh: getMeshes()) {
+        if ((uint64_t) mesh.baseVertex + mesh.vertexCount > m_Header->vertexCount ||
+            (uint64_t) mesh.firstIndex + mesh.indexCount > m_Header->indexCount)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef OPENGL_MESHFILE_H
+#define OPENGL_MESHFILE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include "GeometryArena.h"
+#include "MappedFile.h"
+#include "VertexBufferLayout.h"
+
+/* Binary container for ready-to-draw geometry, read straight out of a file mapping:
+ *
+ *   MeshFileHeader
+ *   MeshFileAttribute[attributeCount]   the VertexBufferLayout the vertices were written with
+ *   MeshRange[meshCount]                one per mesh, all sharing the blobs below (see GeometryArena)
+ *   vertex blob                         vertexCount * vertexStride bytes, at a MESH_FILE_ALIGNMENT offset
+ *   index blob                          indexCount indices of indexType, at a MESH_FILE_ALIGNMENT offset
+ *
+ * Everything is little-endian, the byte order of every platform we build for, so the blobs are
+ * exactly what glBufferData expects. A changed layout bumps MESH_FILE_VERSION; old files are rejected */
+static constexpr char MESH_FILE_MAGIC[4] = {'O', 'G', 'L', 'M'};
+static constexpr uint32_t MESH_FILE_VERSION = 1;
+static constexpr uint64_t MESH_FILE_ALIGNMENT = 64;
+
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t attributeCount;
+    uint32_t meshCount;
+    uint32_t vertexCount;
+    uint32_t vertexStride;
+    uint32_t indexCount;
+    uint32_t indexType; /* GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+};
+
+struct MeshFileAttribute {
+    uint32_t type;
+    uint32_t count;
+    uint32_t normalised;
+    uint32_t location;
+    uint32_t divisor;
+    uint32_t offset;
+};
+
+/* Writes [indices] as 16-bit when every one fits. Written to a temporary file and renamed into place.
+ * An empty [meshes] stores one mesh covering everything. Returns false, with a warning, on failure */
+bool writeMeshFile(const std::filesystem::path &path, const VertexBufferLayout &layout, const void *vertices,
+                   unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount,
+                   const std::vector<MeshRange> &meshes = {});
+
+/* A mesh file mapped into memory. Nothing is parsed beyond checking the header and tables against the
+ * file's size: the vertex and index data point into the mapping and can be given to VertexBuffer and
+ * IndexBuffer(type, data, count) directly, so loading costs the I/O and one driver copy */
+class MeshFile {
+private:
+    MappedFile m_File;
+    const MeshFileHeader *m_Header = nullptr;
+    VertexBufferLayout m_Layout;
+
+public:
+    /* Leaves the file invalid, with a warning, if it is missing, truncated or of another version */
+    explicit MeshFile(const std::filesystem::path &path);
+
+    [[nodiscard]] inline bool isValid() const { return m_Header != nullptr; }
+    [[nodiscard]] inline const VertexBufferLayout &getLayout() const { return m_Layout; }
+    [[nodiscard]] std::span<const MeshRange> getMeshes() const;
+
+    [[nodiscard]] inline unsigned int getVertexCount() const { return m_Header->vertexCount; }
+    [[nodiscard]] inline const void *getVertexData() const { return m_File.getData() + m_Header->vertexOffset; }
+    [[nodiscard]] inline unsigned int getVertexDataSize() const {
+        return m_Header->vertexCount * m_Header->vertexStride;
+    }
+
+    [[nodiscard]] inline unsigned int getIndexCount() const { return m_Header->indexCount; }
+    [[nodiscard]] inline unsigned int getIndexType() const { return m_Header->indexType; }
+    [[nodiscard]] inline const void *getIndexData() const { return m_File.getData() + m_Header->indexOffset; }
+    [[nodiscard]] unsigned int getIndexDataSize() const;
+
+private:
+    [[nodiscard]] bool validate() const;
+};
+
+#endif //OPENGL_MESHFILE_H
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cmath>
+#include "MeshLOD.h"
+#include "MeshSimplifier.h"
+
+/* A level has to drop at least this share of the previous one's indices to be worth keeping */
+static constexpr float MIN_LEVEL_REDUCTION = 0.9f;
+
+LODChain generateLODs(const float *positions, size_t vertexCount, size_t positionStride,
+                      const unsigned int *indices, size_t indexCount, unsigned int maxLevels, float reduction) {
+    LODChain chain;
+    AABB box = {{INFINITY, INFINITY, INFINITY}, {-INFINITY, -INFINITY, -INFINITY}};
+    for (size_t v = 0; v < vertexCount; v++) {
+        auto *p = (const float *) ((const char *) positions + v * positionStride);
+        for (int axis = 0; axis < 3; axis++) {
+            box.min[axis] = std::min(box.min[axis], p[axis]);
+            box.max[axis] = std::max(box.max[axis], p[axis]);
+        }
+    }
+    chain.bounds = vertexCount ? makeBoundingSphere(box) : BoundingSphere{{0.f, 0.f, 0.f}, 0.f};
+
+    chain.indices.assign(indices, indices + indexCount);
+    chain.levels.push_back({0, (unsigned int) indexCount, 0.f});
+
+    std::vector<unsigned int> simplified(indexCount);
+    while (chain.levels.size() < maxLevels) {
+        const LODLevel previous = chain.levels.back();
+        auto target = (size_t) ((float) previous.indexCount * reduction) / 3 * 3;
+        float error = 0.f;
+        size_t count = simplifyMesh(simplified.data(), chain.indices.data() + previous.firstIndex,
+                                    previous.indexCount, positions, vertexCount, positionStride, target,
+                                    INFINITY, &error);
+        if (count == 0 || (float) count > (float) previous.indexCount * MIN_LEVEL_REDUCTION)
+            break;
+
+        chain.levels.push_back({(unsigned int) chain.indices.size(), (unsigned int) count, previous.error + error});
+        chain.indices.insert(chain.indices.end(), simplified.begin(), simplified.begin() + (ptrdiff_t) count);
+    }
+    return chain;
+}
+
+std::optional<MeshLODs> allocateLODs(GeometryArena &arena, const void *vertices, unsigned int vertexCount,
+                                     const LODChain &chain) {
+    std::optional<MeshRange> range = arena.allocate(vertices, vertexCount, chain.indices.data(),
+                                                    (unsigned int) chain.indices.size());
+    if (!range)
+        return std::nullopt;
+
+    MeshLODs lods = {*range, chain.levels, chain.bounds};
+    for (LODLevel &level: lods.levels)
+        level.firstIndex += range->firstIndex;
+    return lods;
+}
+
+LODSelector::LODSelector(float thresholdPixels, float hysteresis) :
+    m_Threshold(thresholdPixels), m_Hysteresis(std::clamp(hysteresis, 0.f, 1.f)) {
+}
+
+void LODSelector::setView(vec3 const eye, float fovY, int viewportHeight) {
+    vec3_dup(m_Eye, eye);
+    m_PixelsPerUnit = (float) viewportHeight / (2.f * std::tan(fovY * 0.5f));
+}
+
+float LODSelector::getProjectedError(float error, const BoundingSphere &bounds) const {
+    vec3 offset;
+    vec3_sub(offset, bounds.center, m_Eye);
+    float distance = vec3_len(offset) - bounds.radius;
+    if (distance <= 0.f)
+        return error > 0.f ? INFINITY : 0.f;
+    return error * m_PixelsPerUnit / distance;
+}
+
+unsigned int LODSelector::select(const std::vector<LODLevel> &levels, const BoundingSphere &bounds,
+                                 unsigned int current, float scale) const {
+    if (levels.empty())
+        return 0;
+
+    auto level = (unsigned int) std::min<size_t>(current, levels.size() - 1);
+    float coarsenThreshold = m_Threshold * (1.f - m_Hysteresis);
+    while (level + 1 < levels.size() &&
+           getProjectedError(levels[level + 1].error * scale, bounds) <= coarsenThreshold)
+        level++;
+    while (level > 0 && getProjectedError(levels[level].error * scale, bounds) > m_Threshold)
+        level--;
+    return level;
+}
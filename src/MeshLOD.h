@@ -0,0 +1,77 @@
+#ifndef OPENGL_MESHLOD_H
+#define OPENGL_MESHLOD_H
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include "Frustum.h"
+#include "GeometryArena.h"
+
+/* One level of detail: a range of indices over the mesh's shared vertices and an estimate of how far, in the
+ * mesh's own units, its surface lies from the full-detail one */
+struct LODLevel {
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error;
+};
+
+/* Every level's indices back to back, finest first, with firstIndex relative to the start of [indices] */
+struct LODChain {
+    std::vector<unsigned int> indices;
+    std::vector<LODLevel> levels;
+    BoundingSphere bounds; /* Of the vertices, in the mesh's own space */
+};
+
+/* A LODChain uploaded to a GeometryArena: one vertex block and one index block holding all levels, with each
+ * level's firstIndex now in the arena */
+struct MeshLODs {
+    MeshRange range;
+    std::vector<LODLevel> levels;
+    BoundingSphere bounds;
+
+    inline MeshRange getLevel(size_t level) const {
+        return {range.baseVertex, range.vertexCount, levels[level].firstIndex, levels[level].indexCount};
+    }
+};
+
+/* Simplifies the mesh level after level, each aiming for [reduction] times the previous level's triangles,
+ * until [maxLevels] exist or the simplifier can't get below 90% of the previous level. Level errors add up
+ * the simplifier's estimates along the way, so they never decrease from one level to the next; like those
+ * estimates they can fall short of the real distance to the original surface.
+ * Positions are read as for simplifyMesh() */
+LODChain generateLODs(const float *positions, size_t vertexCount, size_t positionStride,
+                      const unsigned int *indices, size_t indexCount, unsigned int maxLevels = 4,
+                      float reduction = 0.5f);
+
+/* Returns nothing when the arena has no room */
+std::optional<MeshLODs> allocateLODs(GeometryArena &arena, const void *vertices, unsigned int vertexCount,
+                                     const LODChain &chain);
+
+/* Picks levels by the screen-space size of their error: the coarsest level whose error, projected at the
+ * nearest point of the object's bounds, stays under a pixel threshold. Going coarser needs the error to be
+ * a [hysteresis] fraction below the threshold while going finer happens as soon as it's above, so objects
+ * near a switching distance keep their level rather than alternating every frame. Level errors are estimates,
+ * so a level can be off by somewhat more than the threshold; leave a margin when choosing it */
+class LODSelector {
+private:
+    vec3 m_Eye = {0.f, 0.f, 0.f};
+    float m_PixelsPerUnit = 1.f; /* Projected size of one unit at distance one */
+    float m_Threshold;
+    float m_Hysteresis;
+
+public:
+    explicit LODSelector(float thresholdPixels = 1.f, float hysteresis = 0.25f);
+
+    /* For a perspective projection of vertical field of view [fovY] radians onto [viewportHeight] pixels */
+    void setView(vec3 const eye, float fovY, int viewportHeight);
+
+    /* Pixels covered by [error] at the nearest point of [bounds]; infinite when the eye is inside them */
+    [[nodiscard]] float getProjectedError(float error, const BoundingSphere &bounds) const;
+
+    /* [bounds] are in world space, and [scale] converts the mesh's units to world units (the largest axis
+     * scale of its model matrix). [current] is the level the object was drawn at last time, 0 for new ones */
+    [[nodiscard]] unsigned int select(const std::vector<LODLevel> &levels, const BoundingSphere &bounds,
+                                      unsigned int current, float scale = 1.f) const;
+};
+
+#endif //OPENGL_MESHLOD_H
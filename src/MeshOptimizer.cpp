@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "MeshOptimizer.h"
+
+static constexpr unsigned int EMPTY_SLOT = ~0u;
+
+/* FIFO cache over vertex ids: a vertex is cached while fewer than [size] misses have happened since its own */
+class CacheSimulation {
+private:
+    std::vector<unsigned int> m_MissTime;
+    unsigned int m_Size;
+    unsigned int m_Time;
+
+public:
+    CacheSimulation(size_t vertexCount, unsigned int size) :
+        m_MissTime(vertexCount, 0), m_Size(size), m_Time(size + 1) {
+    }
+
+    /* Returns whether [vertex] had to be transformed */
+    bool access(unsigned int vertex) {
+        if (m_Time - m_MissTime[vertex] <= m_Size)
+            return false;
+        m_MissTime[vertex] = m_Time++;
+        return true;
+    }
+
+    /* Forgets everything, as if the cache were flushed: every vertex is now at least [size] misses old */
+    void flush() { m_Time += m_Size; }
+};
+
+VertexCacheStatistics analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount,
+                                         unsigned int cacheSize) {
+    CacheSimulation cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount);
+    size_t transformed = 0, referencedCount = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        transformed += cache.access(indices[i]);
+        if (!referenced[indices[i]]) {
+            referenced[indices[i]] = true;
+            referencedCount++;
+        }
+    }
+
+    size_t triangleCount = indexCount / 3;
+    return {transformed, triangleCount ? (float) transformed / (float) triangleCount : 0.f,
+            referencedCount ? (float) transformed / (float) referencedCount : 0.f};
+}
+
+/* FNV-1a */
+static uint32_t hashBytes(const unsigned char *bytes, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+/* An open-addressed table of kept vertices, compared by content. Kept vertex k is moved to slot k of the buffer
+ * as soon as it is found; every vertex still to be looked at sits further along, so nothing is overwritten
+ * before it's read */
+size_t deduplicateVertices(void *vertices, size_t vertexCount, size_t vertexSize, unsigned int *indices,
+                           size_t indexCount) {
+    auto *bytes = (unsigned char *) vertices;
+    size_t tableSize = 16;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<unsigned int> table(tableSize, EMPTY_SLOT);
+    std::vector<unsigned int> remap(vertexCount);
+
+    size_t kept = 0;
+    for (size_t v = 0; v < vertexCount; v++) {
+        const unsigned char *vertex = bytes + v * vertexSize;
+        size_t slot = hashBytes(vertex, vertexSize) & (tableSize - 1);
+        while (table[slot] != EMPTY_SLOT && memcmp(bytes + table[slot] * vertexSize, vertex, vertexSize) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == EMPTY_SLOT) {
+            if (kept != v)
+                memcpy(bytes + kept * vertexSize, vertex, vertexSize);
+            table[slot] = (unsigned int) kept++;
+        }
+        remap[v] = table[slot];
+    }
+
+    for (size_t i = 0; i < indexCount; i++)
+        indices[i] = remap[indices[i]];
+    return kept;
+}
+
+/* Appends triangle ids to [order] in Tipsify order, and to [clusterStarts] the position in [order] at which
+ * each run of fanning began; a new run starts whenever the walk hits a dead end */
+static void tipsify(std::vector<unsigned int> &order, std::vector<unsigned int> &clusterStarts,
+                    const unsigned int *indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize) {
+    size_t triangleCount = indexCount / 3;
+
+    /* Triangles around each vertex, and how many of them are still to be emitted */
+    std::vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++)
+        live[indices[i]]++;
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        offsets[v + 1] = offsets[v] + live[v];
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+            adjacency[fill[indices[i]]++] = (unsigned int) (i / 3);
+    }
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    unsigned int time = cacheSize + 1;
+    size_t cursor = 0;
+
+    /* Recently used vertices first, then the next one in index order with triangles left */
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            unsigned int vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (live[vertex] > 0)
+                return vertex;
+        }
+        for (; cursor < vertexCount; cursor++) {
+            if (live[cursor] > 0)
+                return (int64_t) cursor;
+        }
+        return -1;
+    };
+
+    int64_t fanning = skipDeadEnd();
+    while (fanning >= 0) {
+        clusterStarts.push_back((unsigned int) order.size());
+        while (fanning >= 0) {
+            candidates.clear();
+            for (unsigned int k = offsets[fanning]; k < offsets[fanning + 1]; k++) {
+                unsigned int triangle = adjacency[k];
+                if (emitted[triangle])
+                    continue;
+                emitted[triangle] = true;
+                order.push_back(triangle);
+                for (int corner = 0; corner < 3; corner++) {
+                    unsigned int vertex = indices[triangle * 3 + corner];
+                    deadEnds.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    if (time - cacheTime[vertex] > cacheSize)
+                        cacheTime[vertex] = time++;
+                }
+            }
+
+            /* The candidate that will still be cached after its remaining triangles are emitted, preferring the
+             * one that entered the cache earliest; none means a dead end */
+            int64_t next = -1;
+            int64_t bestPriority = -1;
+            for (unsigned int vertex: candidates) {
+                if (live[vertex] == 0)
+                    continue;
+                int64_t priority = 0;
+                if (time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize)
+                    priority = time - cacheTime[vertex];
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    next = vertex;
+                }
+            }
+            fanning = next;
+        }
+        fanning = skipDeadEnd();
+    }
+}
+
+static void writeTriangles(unsigned int *destination, const unsigned int *indices,
+                           const std::vector<unsigned int> &order) {
+    for (size_t i = 0; i < order.size(); i++) {
+        destination[i * 3] = indices[order[i] * 3];
+        destination[i * 3 + 1] = indices[order[i] * 3 + 1];
+        destination[i * 3 + 2] = indices[order[i] * 3 + 2];
+    }
+}
+
+void optimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                         size_t vertexCount, unsigned int cacheSize) {
+    std::vector<unsigned int> order, clusterStarts;
+    order.reserve(indexCount / 3);
+    tipsify(order, clusterStarts, indices, indexCount, vertexCount, cacheSize);
+    writeTriangles(destination, indices, order);
+}
+
+void optimizeOverdraw(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                      const float *positions, size_t vertexCount, size_t positionStride, unsigned int cacheSize,
+                      float threshold) {
+    std::vector<unsigned int> order, hardStarts;
+    order.reserve(indexCount / 3);
+    tipsify(order, hardStarts, indices, indexCount, vertexCount, cacheSize);
+    if (order.empty())
+        return;
+
+    CacheSimulation cache(vertexCount, cacheSize);
+    size_t misses = 0;
+    for (unsigned int triangle: order) {
+        for (int corner = 0; corner < 3; corner++)
+            misses += cache.access(indices[triangle * 3 + corner]);
+    }
+    float targetRatio = threshold * (float) misses / (float) order.size();
+
+    /* Each cluster will be drawn after an unrelated one, so it is measured from a cold cache; a cut is made once
+     * that has been paid back to within [threshold] of the whole mesh's ratio */
+    std::vector<unsigned int> clusterStarts;
+    hardStarts.push_back((unsigned int) order.size());
+    for (size_t hard = 0; hard + 1 < hardStarts.size(); hard++) {
+        size_t clusterMisses = 0, clusterTriangles = 0;
+        cache.flush();
+        clusterStarts.push_back(hardStarts[hard]);
+        for (size_t i = hardStarts[hard]; i < hardStarts[hard + 1]; i++) {
+            for (int corner = 0; corner < 3; corner++)
+                clusterMisses += cache.access(indices[order[i] * 3 + corner]);
+            clusterTriangles++;
+            if (i + 1 < hardStarts[hard + 1] && (float) clusterMisses <= targetRatio * (float) clusterTriangles) {
+                clusterStarts.push_back((unsigned int) (i + 1));
+                clusterMisses = clusterTriangles = 0;
+                cache.flush();
+            }
+        }
+    }
+    clusterStarts.push_back((unsigned int) order.size());
+
+    /* Area-weighted centroid and normal of each cluster, and of the mesh as a whole */
+    struct Cluster {
+        double centroid[3];
+        double normal[3];
+        double area;
+        float sortKey;
+        unsigned int first;
+        unsigned int end;
+    };
+    size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<Cluster> clusters(clusterCount);
+    double meshCentroid[3] = {0.0, 0.0, 0.0}, meshArea = 0.0;
+    for (size_t c = 0; c < clusterCount; c++) {
+        Cluster &cluster = clusters[c];
+        cluster = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, 0.0, 0.f, clusterStarts[c], clusterStarts[c + 1]};
+        for (size_t i = cluster.first; i < cluster.end; i++) {
+            const float *p[3];
+            for (int corner = 0; corner < 3; corner++)
+                p[corner] = (const float *) ((const char *) positions + indices[order[i] * 3 + corner] * positionStride);
+            double u[3] = {p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2]};
+            double v[3] = {p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2]};
+            double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+            double area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5;
+            for (int axis = 0; axis < 3; axis++) {
+                cluster.centroid[axis] += area * (p[0][axis] + p[1][axis] + p[2][axis]) / 3.0;
+                cluster.normal[axis] += n[axis];
+            }
+            cluster.area += area;
+        }
+        for (int axis = 0; axis < 3; axis++)
+            meshCentroid[axis] += cluster.centroid[axis];
+        meshArea += cluster.area;
+    }
+
+    /* How far out along its own normal a cluster lies from the mesh's centre */
+    for (Cluster &cluster: clusters) {
+        double length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] +
+                                  cluster.normal[2] * cluster.normal[2]);
+        if (cluster.area == 0.0 || length == 0.0 || meshArea == 0.0)
+            continue;
+        double key = 0.0;
+        for (int axis = 0; axis < 3; axis++)
+            key += (cluster.centroid[axis] / cluster.area - meshCentroid[axis] / meshArea) * cluster.normal[axis];
+        cluster.sortKey = (float) (key / length);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+    size_t written = 0;
+    for (const Cluster &cluster: clusters) {
+        for (size_t i = cluster.first; i < cluster.end; i++, written++) {
+            destination[written * 3] = indices[order[i] * 3];
+            destination[written * 3 + 1] = indices[order[i] * 3 + 1];
+            destination[written * 3 + 2] = indices[order[i] * 3 + 2];
+        }
+    }
+}
+
+size_t optimizeVertexFetch(void *vertices, size_t vertexCount, size_t vertexSize, unsigned int *indices,
+                           size_t indexCount) {
+    std::vector<unsigned int> remap(vertexCount, EMPTY_SLOT);
+    unsigned int used = 0;
+    for (size_t i = 0; i < indexCount; i++) {
+        unsigned int &target = remap[indices[i]];
+        if (target == EMPTY_SLOT)
+            target = used++;
+        indices[i] = target;
+    }
+
+    auto *bytes = (unsigned char *) vertices;
+    std::vector<unsigned char> original(bytes, bytes + vertexCount * vertexSize);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (remap[v] != EMPTY_SLOT)
+            memcpy(bytes + remap[v] * vertexSize, original.data() + v * vertexSize, vertexSize);
+    }
+    return used;
+}
+
+MeshOptimizationReport optimizeMesh(void *vertices, size_t &vertexCount, size_t vertexSize, size_t positionOffset,
+                                    unsigned int *indices, size_t indexCount, unsigned int cacheSize) {
+    MeshOptimizationReport report = {};
+    report.verticesBefore = vertexCount;
+    report.before = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize);
+
+    vertexCount = deduplicateVertices(vertices, vertexCount, vertexSize, indices, indexCount);
+
+    std::vector<unsigned int> reordered(indexCount);
+    auto *positions = (const float *) ((const unsigned char *) vertices + positionOffset);
+    optimizeOverdraw(reordered.data(), indices, indexCount, positions, vertexCount, vertexSize, cacheSize);
+    std::copy(reordered.begin(), reordered.end(), indices);
+
+    vertexCount = optimizeVertexFetch(vertices, vertexCount, vertexSize, indices, indexCount);
+
+    report.verticesAfter = vertexCount;
+    report.after = analyzeVertexCache(indices, indexCount, vertexCount, cacheSize);
+    return report;
+}
@@ -0,0 +1,55 @@
+#ifndef OPENGL_MESHOPTIMIZER_H
+#define OPENGL_MESHOPTIMIZER_H
+
+#include <cstddef>
+
+/* Import-time reordering of indexed triangle lists for the GPU. The steps are meant to run in the order
+ * optimizeMesh() uses: deduplicate, order triangles for the post-transform cache, reorder clusters of them
+ * against overdraw, then lay vertices out in the order they are first used */
+
+/* Vertices shaded from a cache of the [cacheSize] most recently transformed ones, first in first out */
+struct VertexCacheStatistics {
+    size_t transformedVertices;
+    float acmr; /* Average cache miss ratio: transforms per triangle, 0.5 at best for large regular meshes */
+    float atvr; /* Average transformed vertex ratio: transforms per referenced vertex, 1 at best */
+};
+
+struct MeshOptimizationReport {
+    size_t verticesBefore;
+    size_t verticesAfter;
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+VertexCacheStatistics analyzeVertexCache(const unsigned int *indices, size_t indexCount, size_t vertexCount,
+                                         unsigned int cacheSize = 16);
+
+/* Merges byte-identical vertices, keeping the first of each, and rewrites [indices] to match. Vertices are
+ * compacted in place; returns how many remain */
+size_t deduplicateVertices(void *vertices, size_t vertexCount, size_t vertexSize, unsigned int *indices,
+                           size_t indexCount);
+
+/* Tipsify (Sander, Nehab and Barczak 2007): fans around each vertex in turn, then moves on to the neighbour
+ * most likely to still be in a cache of [cacheSize] entries. Linear time. [destination] may not be [indices] */
+void optimizeVertexCache(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                         size_t vertexCount, unsigned int cacheSize = 16);
+
+/* Splits the Tipsify order into clusters, cut at its dead ends and wherever the cache miss ratio so far is
+ * within [threshold] of the whole mesh's, and sorts the clusters so those facing outwards from the mesh's
+ * centre are drawn first; they tend to hide the rest from most viewpoints. Runs Tipsify itself, so the
+ * input order doesn't matter. [destination] may not be [indices] */
+void optimizeOverdraw(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                      const float *positions, size_t vertexCount, size_t positionStride,
+                      unsigned int cacheSize = 16, float threshold = 1.05f);
+
+/* Reorders vertices by first use in [indices] and rewrites the indices to match, so draws read the vertex
+ * buffer mostly front to back. Unreferenced vertices are dropped; returns how many remain */
+size_t optimizeVertexFetch(void *vertices, size_t vertexCount, size_t vertexSize, unsigned int *indices,
+                           size_t indexCount);
+
+/* All of the above on one mesh, in place. Positions are three floats [positionOffset] bytes into each vertex.
+ * [vertexCount] is updated to the new count */
+MeshOptimizationReport optimizeMesh(void *vertices, size_t &vertexCount, size_t vertexSize, size_t positionOffset,
+                                    unsigned int *indices, size_t indexCount, unsigned int cacheSize = 16);
+
+#endif //OPENGL_MESHOPTIMIZER_H
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "MeshSimplifier.h"
+
+/* Collapses may turn a remaining triangle's normal by up to about 75 degrees. Allowing anything short of a
+ * flip lets sequences of collapses fold thin triangles over their neighbours */
+static constexpr float MIN_NORMAL_COSINE = 0.25f;
+
+/* Sum of squared distances to a set of planes, each weighted by its triangle's area, as the symmetric matrix,
+ * vector and constant of p.A.p + 2 b.p + c. Dividing by the total weight gives a mean squared distance */
+struct Quadric {
+    double a00, a11, a22, a01, a02, a12;
+    double b0, b1, b2;
+    double c;
+    double weight;
+};
+
+static inline void addQuadric(Quadric &q, const Quadric &other) {
+    q.a00 += other.a00;
+    q.a11 += other.a11;
+    q.a22 += other.a22;
+    q.a01 += other.a01;
+    q.a02 += other.a02;
+    q.a12 += other.a12;
+    q.b0 += other.b0;
+    q.b1 += other.b1;
+    q.b2 += other.b2;
+    q.c += other.c;
+    q.weight += other.weight;
+}
+
+static Quadric makePlaneQuadric(const float *p0, const float *p1, const float *p2) {
+    double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+    double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (length == 0.0)
+        return {};
+
+    n[0] /= length;
+    n[1] /= length;
+    n[2] /= length;
+    double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+    double w = length * 0.5;
+    return {w * n[0] * n[0], w * n[1] * n[1], w * n[2] * n[2], w * n[0] * n[1], w * n[0] * n[2], w * n[1] * n[2],
+            w * d * n[0], w * d * n[1], w * d * n[2], w * d * d, w};
+}
+
+/* Weighted mean squared distance of [p] to the quadric's planes */
+static double evaluateQuadric(const Quadric &q, const float *p) {
+    double x = p[0], y = p[1], z = p[2];
+    double sum = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+                 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) + q.c;
+    return q.weight > 0.0 ? std::max(sum / q.weight, 0.0) : 0.0;
+}
+
+/* Unnormalised, with the triangle's area as its length (times two) */
+static inline void triangleNormal(float n[3], const float *a, const float *b, const float *c) {
+    float u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    float v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+namespace {
+    struct Collapse {
+        float cost; /* Squared distance */
+        unsigned int from;
+        unsigned int to;
+    };
+
+    struct PositionHash {
+        size_t operator()(const std::array<uint32_t, 3> &key) const {
+            return (size_t) key[0] * 73856093u ^ (size_t) key[1] * 19349663u ^ (size_t) key[2] * 83492791u;
+        }
+    };
+}
+
+size_t simplifyMesh(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                    const float *positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount,
+                    float maxError, float *resultError) {
+    auto position = [&](unsigned int vertex) {
+        return (const float *) ((const char *) positions + vertex * positionStride);
+    };
+
+    /* Vertices sharing a position are wedges of one point; quadrics and topology are tracked per point. Only
+     * referenced vertices count as wedges, since coarser levels leave many of the buffer's vertices unused */
+    std::vector<bool> referenced(vertexCount);
+    for (size_t i = 0; i < indexCount; i++)
+        referenced[indices[i]] = true;
+
+    std::vector<unsigned int> points(vertexCount);
+    std::vector<unsigned int> wedgeCounts;
+    std::unordered_map<std::array<uint32_t, 3>, unsigned int, PositionHash> pointOf;
+    pointOf.reserve(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        if (!referenced[v])
+            continue;
+        std::array<uint32_t, 3> key;
+        memcpy(key.data(), position((unsigned int) v), sizeof(key));
+        auto [entry, inserted] = pointOf.try_emplace(key, (unsigned int) wedgeCounts.size());
+        if (inserted)
+            wedgeCounts.push_back(0);
+        points[v] = entry->second;
+        wedgeCounts[entry->second]++;
+    }
+
+    /* Edges used by one triangle are borders, by more than two non-manifold; either locks both ends */
+    std::vector<bool> lockedPoints(wedgeCounts.size());
+    for (size_t point = 0; point < wedgeCounts.size(); point++)
+        lockedPoints[point] = wedgeCounts[point] > 1;
+
+    std::unordered_map<uint64_t, unsigned int> edgeUses;
+    edgeUses.reserve(indexCount);
+    std::vector<Quadric> quadrics(wedgeCounts.size(), Quadric{});
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        Quadric plane = makePlaneQuadric(position(indices[i]), position(indices[i + 1]), position(indices[i + 2]));
+        for (int corner = 0; corner < 3; corner++) {
+            unsigned int a = points[indices[i + corner]], b = points[indices[i + (corner + 1) % 3]];
+            addQuadric(quadrics[a], plane);
+            if (a != b)
+                edgeUses[(uint64_t) std::min(a, b) << 32 | std::max(a, b)]++;
+        }
+    }
+    for (const auto &[edge, uses]: edgeUses) {
+        if (uses != 2) {
+            lockedPoints[edge >> 32] = true;
+            lockedPoints[edge & 0xFFFFFFFFu] = true;
+        }
+    }
+
+    std::vector<unsigned int> current(indices, indices + indexCount);
+    std::vector<unsigned int> triangleOffsets(vertexCount + 1);
+    std::vector<unsigned int> vertexTriangles;
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> collapseTo(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        collapseTo[v] = (unsigned int) v;
+    std::vector<bool> touched(vertexCount);
+    std::vector<unsigned int> fromNeighbours, toNeighbours;
+    double maxCost = (double) maxError * maxError;
+    double largestCost = 0.0;
+
+    /* Each pass collapses the cheapest edges that don't share a neighbourhood, so the checks below see
+     * triangles no other collapse of the pass has changed */
+    while (current.size() > targetIndexCount) {
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0u);
+        for (unsigned int vertex: current)
+            triangleOffsets[vertex + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        vertexTriangles.resize(current.size());
+        {
+            std::vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (size_t i = 0; i < current.size(); i++)
+                vertexTriangles[fill[current[i]]++] = (unsigned int) (i / 3);
+        }
+
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3) {
+            for (int corner = 0; corner < 3; corner++) {
+                unsigned int a = current[i + corner], b = current[i + (corner + 1) % 3];
+                for (int direction = 0; direction < 2; direction++, std::swap(a, b)) {
+                    if (lockedPoints[points[a]] || points[a] == points[b])
+                        continue;
+                    Quadric merged = quadrics[points[a]];
+                    addQuadric(merged, quadrics[points[b]]);
+                    collapses.push_back({(float) evaluateQuadric(merged, position(b)), a, b});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+        std::fill(touched.begin(), touched.end(), false);
+        size_t goal = (current.size() - targetIndexCount + 2) / 3;
+        size_t removed = 0;
+        std::vector<unsigned int> collapsed;
+        for (const Collapse &collapse: collapses) {
+            if (collapse.cost > maxCost || removed >= goal)
+                break;
+            unsigned int from = collapse.from, to = collapse.to;
+            if (touched[from] || touched[to])
+                continue;
+
+            /* Triangles on the edge vanish; the rest of [from]'s fan must not flip once moved to [to] */
+            size_t shared = 0;
+            bool flips = false;
+            fromNeighbours.clear();
+            for (unsigned int k = triangleOffsets[from]; k < triangleOffsets[from + 1] && !flips; k++) {
+                const unsigned int *triangle = &current[vertexTriangles[k] * 3];
+                int corner = triangle[0] == from ? 0 : triangle[1] == from ? 1 : 2;
+                unsigned int p = triangle[(corner + 1) % 3], q = triangle[(corner + 2) % 3];
+                fromNeighbours.push_back(p);
+                fromNeighbours.push_back(q);
+                if (p == to || q == to) {
+                    shared++;
+                    continue;
+                }
+
+                float before[3], after[3];
+                triangleNormal(before, position(from), position(p), position(q));
+                triangleNormal(after, position(to), position(p), position(q));
+                float cosine = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                float lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                                          (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                flips = cosine <= MIN_NORMAL_COSINE * lengths;
+            }
+            if (flips || shared == 0)
+                continue;
+
+            /* Link condition: the ends may only share the neighbours opposite the edge, or the collapse would
+             * pinch the surface into a non-manifold fin */
+            toNeighbours.clear();
+            for (unsigned int k = triangleOffsets[to]; k < triangleOffsets[to + 1]; k++) {
+                const unsigned int *triangle = &current[vertexTriangles[k] * 3];
+                for (int corner = 0; corner < 3; corner++) {
+                    if (triangle[corner] != to)
+                        toNeighbours.push_back(triangle[corner]);
+                }
+            }
+            std::sort(fromNeighbours.begin(), fromNeighbours.end());
+            fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+            std::sort(toNeighbours.begin(), toNeighbours.end());
+            toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+            size_t common = 0;
+            for (size_t i = 0, j = 0; i < fromNeighbours.size() && j < toNeighbours.size();) {
+                if (fromNeighbours[i] < toNeighbours[j]) {
+                    i++;
+                } else if (fromNeighbours[i] > toNeighbours[j]) {
+                    j++;
+                } else {
+                    common++;
+                    i++;
+                    j++;
+                }
+            }
+            if (common > shared)
+                continue;
+
+            collapseTo[from] = to;
+            collapsed.push_back(from);
+            addQuadric(quadrics[points[to]], quadrics[points[from]]);
+            largestCost = std::max(largestCost, (double) collapse.cost);
+            removed += shared;
+
+            touched[from] = touched[to] = true;
+            for (unsigned int neighbour: fromNeighbours)
+                touched[neighbour] = true;
+            for (unsigned int neighbour: toNeighbours)
+                touched[neighbour] = true;
+        }
+        if (collapsed.empty())
+            break;
+
+        size_t written = 0;
+        for (size_t i = 0; i < current.size(); i += 3) {
+            unsigned int a = collapseTo[current[i]], b = collapseTo[current[i + 1]], c = collapseTo[current[i + 2]];
+            if (a == b || b == c || a == c)
+                continue;
+            current[written++] = a;
+            current[written++] = b;
+            current[written++] = c;
+        }
+        current.resize(written);
+        for (unsigned int vertex: collapsed)
+            collapseTo[vertex] = vertex;
+    }
+
+    std::copy(current.begin(), current.end(), destination);
+    if (resultError)
+        *resultError = (float) std::sqrt(largestCost);
+    return current.size();
+}
@@ -0,0 +1,20 @@
+#ifndef OPENGL_MESHSIMPLIFIER_H
+#define OPENGL_MESHSIMPLIFIER_H
+
+#include <cmath>
+#include <cstddef>
+
+/* Reduces an indexed triangle list towards [targetIndexCount] indices by collapsing edges in order of quadric
+ * error, without creating vertices: the result indexes the same vertex buffer, so every level of detail of a
+ * mesh can share one. Vertices on open borders, on attribute seams (several vertices at one position) and on
+ * non-manifold edges never move, so outlines and UV seams are kept; other vertices may collapse into them.
+ * Stops early when no collapse stays within [maxError], in the units of the positions.
+ * [positions] points at the first vertex's x, with [positionStride] bytes between vertices. [destination]
+ * needs room for [indexCount] and may be [indices]. Returns the number of indices written; [resultError]
+ * receives the square root of the largest quadric cost of any collapse made. That estimates how far the surface
+ * moved, but isn't a bound: quadrics merged over successive collapses can understate the real distance */
+size_t simplifyMesh(unsigned int *destination, const unsigned int *indices, size_t indexCount,
+                    const float *positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount,
+                    float maxError = INFINITY, float *resultError = nullptr);
+
+#endif //OPENGL_MESHSIMPLIFIER_H
@@ -0,0 +1,363 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "ObjImporter.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+static_assert(offsetof(ObjVertex, texCoord) == ObjVertex::Layout::offsets[1]);
+static_assert(offsetof(ObjVertex, normal) == ObjVertex::Layout::offsets[2]);
+
+/* Large enough that splitting and merging cost little next to parsing, small enough to balance across threads */
+static constexpr size_t OBJ_CHUNK_SIZE = 1 << 20;
+static constexpr size_t OBJ_VERTEX_GRAIN = 16384;
+
+/* Indices as parsed, 0-based. A negative OBJ index counts back from the last vertex read so far, which a chunk
+ * only knows relative to its own start; those are stored chunk-local with their bit set in [relative] and
+ * rebased once every chunk's counts are known. -1 means the corner has no such attribute */
+struct ObjCorner {
+    int32_t position;
+    int32_t texCoord;
+    int32_t normal;
+    uint32_t relative;
+};
+
+static constexpr uint32_t RELATIVE_POSITION = 1, RELATIVE_TEXCOORD = 2, RELATIVE_NORMAL = 4;
+
+struct ObjMaterialSwitch {
+    size_t firstCorner;
+    std::string_view material;
+};
+
+struct ObjChunk {
+    std::vector<float> positions;
+    std::vector<float> texCoords;
+    std::vector<float> normals;
+    std::vector<ObjCorner> corners; /* Three per triangle */
+    std::vector<ObjMaterialSwitch> materials;
+    std::vector<ObjCorner> polygon;
+    size_t malformedLines = 0;
+    bool brokenIndices = false;
+    bool hasTexCoords = false;
+    bool hasNormals = false;
+};
+
+static const char *skipSpaces(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    return p;
+}
+
+static bool parseFloat(const char *&p, const char *end, float &value) {
+    p = skipSpaces(p, end);
+    if (p < end && *p == '+')
+        p++;
+    auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc())
+        return false;
+    p = next;
+    return true;
+}
+
+static bool parseFloats(const char *p, const char *end, std::vector<float> &values, int count, int required) {
+    float parsed[3] = {0.f, 0.f, 0.f};
+    for (int i = 0; i < count; i++) {
+        if (!parseFloat(p, end, parsed[i]) && i < required)
+            return false;
+    }
+    values.insert(values.end(), parsed, parsed + count);
+    return true;
+}
+
+/* [readSoFar] is how many of this kind of attribute the chunk has read, for negative indices */
+static bool parseIndex(const char *&p, const char *end, size_t readSoFar, int32_t &index, uint32_t &relative,
+                       uint32_t relativeBit) {
+    long value = 0;
+    auto [next, error] = std::from_chars(p, end, value);
+    if (error != std::errc() || value == 0 || value > INT32_MAX || value < INT32_MIN)
+        return false;
+    p = next;
+    if (value > 0) {
+        index = (int32_t) (value - 1);
+    } else {
+        index = (int32_t) ((int64_t) readSoFar + value);
+        relative |= relativeBit;
+    }
+    return true;
+}
+
+/* Corners are v, v/vt, v//vn or v/vt/vn */
+static bool parseFace(const char *p, const char *end, ObjChunk &chunk) {
+    chunk.polygon.clear();
+    while (true) {
+        p = skipSpaces(p, end);
+        if (p == end || *p == '\r' || *p == '#')
+            break;
+
+        ObjCorner corner = {-1, -1, -1, 0};
+        if (!parseIndex(p, end, chunk.positions.size() / 3, corner.position, corner.relative, RELATIVE_POSITION))
+            return false;
+        if (p < end && *p == '/') {
+            p++;
+            if (p < end && *p != '/' &&
+                !parseIndex(p, end, chunk.texCoords.size() / 2, corner.texCoord, corner.relative, RELATIVE_TEXCOORD))
+                return false;
+            if (p < end && *p == '/') {
+                p++;
+                if (!parseIndex(p, end, chunk.normals.size() / 3, corner.normal, corner.relative, RELATIVE_NORMAL))
+                    return false;
+            }
+        }
+        chunk.polygon.push_back(corner);
+    }
+    if (chunk.polygon.size() < 3)
+        return false;
+
+    for (size_t i = 1; i + 1 < chunk.polygon.size(); i++) {
+        chunk.corners.push_back(chunk.polygon[0]);
+        chunk.corners.push_back(chunk.polygon[i]);
+        chunk.corners.push_back(chunk.polygon[i + 1]);
+    }
+    return true;
+}
+
+static bool startsWith(const char *p, const char *end, std::string_view keyword) {
+    return (size_t) (end - p) > keyword.size() && std::string_view(p, keyword.size()) == keyword &&
+           (p[keyword.size()] == ' ' || p[keyword.size()] == '\t');
+}
+
+static void parseChunk(const char *p, const char *end, ObjChunk &chunk) {
+    while (p < end) {
+        auto *lineEnd = (const char *) memchr(p, '\n', (size_t) (end - p));
+        if (!lineEnd)
+            lineEnd = end;
+        p = skipSpaces(p, lineEnd);
+
+        bool parsed = true;
+        if (startsWith(p, lineEnd, "v"))
+            parsed = parseFloats(p + 2, lineEnd, chunk.positions, 3, 3);
+        else if (startsWith(p, lineEnd, "vt"))
+            parsed = parseFloats(p + 3, lineEnd, chunk.texCoords, 2, 1);
+        else if (startsWith(p, lineEnd, "vn"))
+            parsed = parseFloats(p + 3, lineEnd, chunk.normals, 3, 3);
+        else if (startsWith(p, lineEnd, "f"))
+            parsed = parseFace(p + 2, lineEnd, chunk);
+        else if (startsWith(p, lineEnd, "usemtl")) {
+            const char *name = skipSpaces(p + 7, lineEnd);
+            const char *nameEnd = lineEnd;
+            while (nameEnd > name && (nameEnd[-1] == '\r' || nameEnd[-1] == ' ' || nameEnd[-1] == '\t'))
+                nameEnd--;
+            chunk.materials.push_back({chunk.corners.size(), std::string_view(name, (size_t) (nameEnd - name))});
+        }
+        if (!parsed)
+            chunk.malformedLines++;
+        p = lineEnd + 1;
+    }
+}
+
+/* A vertex is one distinct combination of attribute indices; ~0u marks a missing attribute */
+struct ObjVertexKey {
+    uint32_t position;
+    uint32_t texCoord;
+    uint32_t normal;
+
+    inline bool operator==(const ObjVertexKey &other) const = default;
+};
+
+static uint32_t hashKey(const ObjVertexKey &key) {
+    uint64_t hash = key.position * 0x9e3779b97f4a7c15ull;
+    hash ^= (key.texCoord + (hash >> 29)) * 0xbf58476d1ce4e5b9ull;
+    hash ^= (key.normal + (hash >> 31)) * 0x94d049bb133111ebull;
+    return (uint32_t) (hash >> 32);
+}
+
+/* Rebases one index to the whole file. Only an absolute -1 means the attribute is missing; a relative index has
+ * to land on an attribute that exists */
+static bool resolveIndex(int32_t &index, bool relative, size_t base, size_t total, bool optional) {
+    int64_t resolved = index + (relative ? (int64_t) base : 0);
+    bool missing = optional && !relative && resolved == -1;
+    if (!missing && (resolved < 0 || resolved >= (int64_t) total))
+        return false;
+    index = (int32_t) resolved;
+    return true;
+}
+
+/* Rebases one chunk's indices to the whole file and checks them; false if any is out of range */
+static bool resolveCorners(ObjChunk &chunk, const size_t bases[3], const size_t totals[3]) {
+    for (ObjCorner &corner: chunk.corners) {
+        if (!resolveIndex(corner.position, corner.relative & RELATIVE_POSITION, bases[0], totals[0], false) ||
+            !resolveIndex(corner.texCoord, corner.relative & RELATIVE_TEXCOORD, bases[1], totals[1], true) ||
+            !resolveIndex(corner.normal, corner.relative & RELATIVE_NORMAL, bases[2], totals[2], true))
+            return false;
+        corner.relative = 0;
+        chunk.hasTexCoords |= corner.texCoord >= 0;
+        chunk.hasNormals |= corner.normal >= 0;
+    }
+    return true;
+}
+
+std::optional<ObjModel> parseObj(std::string_view text, ThreadPool *pool) {
+    /* Chunks end just after a newline, so no line is split between two of them */
+    std::vector<size_t> starts = {0};
+    while (starts.back() + OBJ_CHUNK_SIZE < text.size()) {
+        size_t newline = text.find('\n', starts.back() + OBJ_CHUNK_SIZE);
+        if (newline == std::string_view::npos)
+            break;
+        starts.push_back(newline + 1);
+    }
+    starts.push_back(text.size());
+
+    size_t chunkCount = starts.size() - 1;
+    std::vector<ObjChunk> chunks(chunkCount);
+    auto parseChunks = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            parseChunk(text.data() + starts[i], text.data() + starts[i + 1], chunks[i]);
+    };
+    if (pool)
+        pool->parallelFor(chunkCount, 1, parseChunks);
+    else
+        parseChunks(0, chunkCount);
+
+    /* Where each chunk's attributes start in the whole file */
+    std::vector<size_t> bases(chunkCount * 3);
+    size_t totals[3] = {0, 0, 0}, malformedLines = 0;
+    for (size_t i = 0; i < chunkCount; i++) {
+        bases[i * 3] = totals[0];
+        bases[i * 3 + 1] = totals[1];
+        bases[i * 3 + 2] = totals[2];
+        totals[0] += chunks[i].positions.size() / 3;
+        totals[1] += chunks[i].texCoords.size() / 2;
+        totals[2] += chunks[i].normals.size() / 3;
+        malformedLines += chunks[i].malformedLines;
+    }
+    if (malformedLines)
+        std::cout << "Warning: skipped " << malformedLines << " malformed OBJ lines" << std::endl;
+
+    auto resolveChunks = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            chunks[i].brokenIndices = !resolveCorners(chunks[i], &bases[i * 3], totals);
+    };
+    if (pool)
+        pool->parallelFor(chunkCount, 1, resolveChunks);
+    else
+        resolveChunks(0, chunkCount);
+
+    ObjModel model;
+    size_t cornerCount = 0;
+    for (size_t i = 0; i < chunkCount; i++) {
+        if (chunks[i].brokenIndices) {
+            std::cout << "Warning: OBJ face refers to a vertex that doesn't exist" << std::endl;
+            return std::nullopt;
+        }
+        model.hasTexCoords |= chunks[i].hasTexCoords;
+        model.hasNormals |= chunks[i].hasNormals;
+        cornerCount += chunks[i].corners.size();
+    }
+    if (cornerCount > UINT32_MAX) {
+        std::cout << "Warning: OBJ has too many faces for 32-bit indices" << std::endl;
+        return std::nullopt;
+    }
+
+    /* Merge corners into vertices through an open-addressed table of the keys seen so far. Keys are kept in the
+     * slots so a probe touches one cache line. Most files have about one vertex per position, so that sizes the
+     * table, and it doubles whenever it gets half full */
+    struct Slot {
+        ObjVertexKey key;
+        uint32_t vertex;
+    };
+    size_t tableSize = 16;
+    while (tableSize < totals[0] * 2)
+        tableSize *= 2;
+    std::vector<Slot> table(tableSize, Slot{{0, 0, 0}, ~0u});
+    std::vector<ObjVertexKey> keys;
+    auto findSlot = [&](const ObjVertexKey &key) -> Slot & {
+        size_t slot = hashKey(key) & (tableSize - 1);
+        while (table[slot].vertex != ~0u && !(table[slot].key == key))
+            slot = (slot + 1) & (tableSize - 1);
+        return table[slot];
+    };
+    model.indices.resize(cornerCount);
+    model.groups.push_back({"", 0, 0});
+    size_t index = 0;
+    for (const ObjChunk &chunk: chunks) {
+        size_t nextSwitch = 0;
+        for (size_t c = 0; c <= chunk.corners.size(); c++) {
+            while (nextSwitch < chunk.materials.size() && chunk.materials[nextSwitch].firstCorner == c) {
+                ObjGroup &current = model.groups.back();
+                current.indexCount = (unsigned int) index - current.firstIndex;
+                if (current.indexCount == 0)
+                    model.groups.pop_back();
+                model.groups.push_back({std::string(chunk.materials[nextSwitch].material), (unsigned int) index, 0});
+                nextSwitch++;
+            }
+            if (c == chunk.corners.size())
+                break;
+
+            const ObjCorner &corner = chunk.corners[c];
+            ObjVertexKey key = {(uint32_t) corner.position, (uint32_t) corner.texCoord, (uint32_t) corner.normal};
+            Slot &slot = findSlot(key);
+            uint32_t vertex = slot.vertex;
+            if (vertex == ~0u) {
+                vertex = (uint32_t) keys.size();
+                slot = {key, vertex};
+                keys.push_back(key);
+                if (keys.size() * 2 > tableSize) {
+                    tableSize *= 2;
+                    table.assign(tableSize, Slot{{0, 0, 0}, ~0u});
+                    for (size_t v = 0; v < keys.size(); v++)
+                        findSlot(keys[v]) = {keys[v], (uint32_t) v};
+                }
+            }
+            model.indices[index++] = vertex;
+        }
+    }
+    ObjGroup &last = model.groups.back();
+    last.indexCount = (unsigned int) index - last.firstIndex;
+    if (last.indexCount == 0)
+        model.groups.pop_back();
+
+    /* Concatenate each chunk's attributes, then fill in every vertex from them */
+    std::vector<float> positions(totals[0] * 3), texCoords(totals[1] * 2), normals(totals[2] * 3);
+    auto gatherChunks = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            std::copy(chunks[i].positions.begin(), chunks[i].positions.end(), positions.begin() + bases[i * 3] * 3);
+            std::copy(chunks[i].texCoords.begin(), chunks[i].texCoords.end(),
+                      texCoords.begin() + bases[i * 3 + 1] * 2);
+            std::copy(chunks[i].normals.begin(), chunks[i].normals.end(), normals.begin() + bases[i * 3 + 2] * 3);
+        }
+    };
+    model.vertices.resize(keys.size());
+    auto fillVertices = [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; v++) {
+            const ObjVertexKey &key = keys[v];
+            ObjVertex &vertex = model.vertices[v];
+            std::copy_n(&positions[key.position * 3], 3, vertex.position);
+            if (key.texCoord != ~0u)
+                std::copy_n(&texCoords[key.texCoord * 2], 2, vertex.texCoord);
+            else
+                vertex.texCoord[0] = vertex.texCoord[1] = 0.f;
+            if (key.normal != ~0u)
+                std::copy_n(&normals[key.normal * 3], 3, vertex.normal);
+            else
+                vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.f;
+        }
+    };
+    if (pool) {
+        pool->parallelFor(chunkCount, 1, gatherChunks);
+        pool->parallelFor(keys.size(), OBJ_VERTEX_GRAIN, fillVertices);
+    } else {
+        gatherChunks(0, chunkCount);
+        fillVertices(0, keys.size());
+    }
+    return model;
+}
+
+std::optional<ObjModel> importObj(const std::filesystem::path &path, ThreadPool *pool) {
+    MappedFile file(path);
+    if (!file.isOpen())
+        return std::nullopt;
+    return parseObj(std::string_view((const char *) file.getData(), file.getSize()), pool);
+}
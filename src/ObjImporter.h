@@ -0,0 +1,48 @@
+#ifndef OPENGL_OBJIMPORTER_H
+#define OPENGL_OBJIMPORTER_H
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "VertexLayout.h"
+
+class ThreadPool;
+
+struct ObjVertex {
+    float position[3];
+    float texCoord[2];
+    float normal[3];
+
+    using Layout = VertexLayout<Attr<float, 3>, Attr<float, 2>, Attr<float, 3>>;
+};
+
+/* Faces drawn with one material: a run of indices between two usemtl statements */
+struct ObjGroup {
+    std::string material;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+/* Ready for VertexBuffer(vertices.data(), vertices.size() * sizeof(ObjVertex)) with makeVertexLayout<ObjVertex>,
+ * and IndexBuffer(indices.data(), indices.size()). Texture coordinates and normals the file doesn't give are
+ * zero */
+struct ObjModel {
+    std::vector<ObjVertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<ObjGroup> groups;
+    bool hasTexCoords = false;
+    bool hasNormals = false;
+};
+
+/* Reads v, vt, vn, f and usemtl statements, triangulating polygons as fans; everything else is skipped. The text
+ * is split at line boundaries into chunks parsed in parallel on [pool], then every distinct position/texture
+ * coordinate/normal triple becomes one vertex. Malformed lines are skipped with a warning; returns nothing,
+ * with a warning, if a face refers to a vertex that doesn't exist */
+std::optional<ObjModel> parseObj(std::string_view text, ThreadPool *pool = nullptr);
+
+/* parseObj() over the file, mapped rather than read; returns nothing, with a warning, if it can't be mapped */
+std::optional<ObjModel> importObj(const std::filesystem::path &path, ThreadPool *pool = nullptr);
+
+#endif //OPENGL_OBJIMPORTER_H
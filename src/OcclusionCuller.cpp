@@ -0,0 +1,371 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include "OcclusionCuller.h"
+#include "Float4.h"
+#include "GLState.h"
+#include "Renderer.h"
+#include "Shader.h"
+
+/* The GPU's interpolated depth and the CPU's projected corners round the same surface differently; an occluder's
+ * own bounds must not end up behind it */
+static constexpr float DEPTH_EPSILON = 1e-6f;
+/* Corners this close to the eye plane or behind it make the projection meaningless */
+static constexpr float MIN_CLIP_W = 1e-5f;
+
+/* A triangle covering the viewport, from gl_VertexID alone */
+static const char *DOWNSAMPLE_VERTEX = R"(#version 330
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
+)";
+
+/* Occluders are rasterised by texel centre, so a texel can hold an occluder that covers only part of it. Taking
+ * the farthest depth of the 3x3 texels around each one, with texels past the edge as far as they go, leaves
+ * every texel no nearer than anything within its area */
+static const char *DILATE_FRAGMENT = R"(#version 330
+uniform sampler2D u_Depth;
+void main()
+{
+    ivec2 size = textureSize(u_Depth, 0);
+    ivec2 center = ivec2(gl_FragCoord.xy);
+    float depth = 0.0;
+    for (int y = center.y - 1; y <= center.y + 1; y++) {
+        for (int x = center.x - 1; x <= center.x + 1; x++) {
+            bool inside = x >= 0 && y >= 0 && x < size.x && y < size.y;
+            depth = max(depth, inside ? texelFetch(u_Depth, ivec2(x, y), 0).r : 1.0);
+        }
+    }
+    gl_FragDepth = depth;
+}
+)";
+
+/* Farthest of the 2x2 texels under this one in the level above, which is the texture's only visible level.
+ * An odd-sized level's last row and column fold into the texels before them */
+static const char *DOWNSAMPLE_FRAGMENT = R"(#version 330
+uniform sampler2D u_Depth;
+void main()
+{
+    ivec2 last = textureSize(u_Depth, 0) - 1;
+    ivec2 first = ivec2(gl_FragCoord.xy) * 2;
+    ivec2 end = min(first + 1 + ivec2(equal(first + 2, last)), last);
+    float depth = 0.0;
+    for (int y = first.y; y <= end.y; y++)
+        for (int x = first.x; x <= end.x; x++)
+            depth = max(depth, texelFetch(u_Depth, ivec2(x, y), 0).r);
+    gl_FragDepth = depth;
+}
+)";
+
+OcclusionCuller::OcclusionCuller(int width, int height) :
+    m_Width(std::max(width, 1)), m_Height(std::max(height, 1)), m_ChainSize(0), m_RasterTexture(0),
+    m_DepthTexture(0), m_Framebuffer(0) {
+    /* Level sizes follow GL's rule, halved and rounded down until both reach 1 */
+    for (int w = m_Width, h = m_Height;; w = std::max(w / 2, 1), h = std::max(h / 2, 1)) {
+        m_Levels.push_back({w, h, m_ChainSize});
+        m_ChainSize += (size_t) w * h;
+        if (w == 1 && h == 1)
+            break;
+    }
+    auto levelCount = (int) m_Levels.size();
+
+    int texture;
+    GLCall(glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture));
+    GLCall(glGenTextures(1, &m_RasterTexture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RasterTexture));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, m_Width, m_Height, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+                        nullptr));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+
+    GLCall(glGenTextures(1, &m_DepthTexture));
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_DepthTexture));
+    for (int level = 0; level < levelCount; level++) {
+        GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT32F, m_Levels[level].width,
+                            m_Levels[level].height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr));
+    }
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+    GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+
+    int drawFramebuffer, readFramebuffer;
+    GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer));
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer));
+    GLCall(glGenFramebuffers(1, &m_Framebuffer));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_RasterTexture, 0));
+    GLCall(glDrawBuffer(GL_NONE));
+    GLCall(glReadBuffer(GL_NONE));
+    GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Warning: occlusion depth target incomplete (" << status << ")" << std::endl;
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFramebuffer));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, readFramebuffer));
+
+    for (Readback &readback: m_Readbacks) {
+        readback.fence = nullptr;
+        readback.frame = 0;
+        GLCall(glGenBuffers(1, &readback.buffer));
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer));
+        GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) (m_ChainSize * sizeof(float)), nullptr,
+                            GL_STREAM_READ));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+    m_DilateShader = std::make_unique<Shader>(ShaderProgramSource{DOWNSAMPLE_VERTEX, DILATE_FRAGMENT},
+                                              "Hi-Z dilate");
+    m_DownsampleShader = std::make_unique<Shader>(ShaderProgramSource{DOWNSAMPLE_VERTEX, DOWNSAMPLE_FRAGMENT},
+                                                  "Hi-Z downsample");
+    mat4x4_identity(m_OccluderViewProjection);
+    mat4x4_identity(m_DepthViewProjection);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+    for (Readback &readback: m_Readbacks) {
+        if (readback.fence) {
+            GLCall(glDeleteSync((GLsync) readback.fence));
+        }
+        GLCall(glDeleteBuffers(1, &readback.buffer));
+    }
+    GLCall(glDeleteFramebuffers(1, &m_Framebuffer));
+    GLCall(glDeleteTextures(1, &m_DepthTexture));
+    GLCall(glDeleteTextures(1, &m_RasterTexture));
+}
+
+void OcclusionCuller::beginOccluders(mat4x4 const viewProjection) {
+    mat4x4_dup(m_OccluderViewProjection, viewProjection);
+
+    GLCall(m_DepthTestEnabled = glIsEnabled(GL_DEPTH_TEST));
+    GLCall(glGetIntegerv(GL_DEPTH_FUNC, &m_DepthFunc));
+    GLCall(glGetBooleanv(GL_DEPTH_WRITEMASK, &m_DepthMask));
+    GLCall(glGetIntegerv(GL_VIEWPORT, m_Viewport));
+    GLCall(glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &m_DrawFramebuffer));
+    GLCall(glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &m_ReadFramebuffer));
+
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer));
+    GLState::get().viewport(0, 0, m_Width, m_Height);
+    GLCall(glEnable(GL_DEPTH_TEST));
+    GLCall(glDepthFunc(GL_LESS));
+    GLCall(glDepthMask(GL_TRUE));
+    GLCall(glClear(GL_DEPTH_BUFFER_BIT));
+}
+
+void OcclusionCuller::endOccluders() {
+    /* The chain is built and read back through unit 0 with m_DepthTexture bound */
+    int activeTexture, texture;
+    GLCall(glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture));
+    GLCall(glActiveTexture(GL_TEXTURE0));
+    GLCall(glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture));
+    buildHierarchy();
+
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_DrawFramebuffer));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_ReadFramebuffer));
+    GLState::get().viewport(m_Viewport[0], m_Viewport[1], m_Viewport[2], m_Viewport[3]);
+    if (!m_DepthTestEnabled) {
+        GLCall(glDisable(GL_DEPTH_TEST));
+    }
+    GLCall(glDepthFunc(m_DepthFunc));
+    GLCall(glDepthMask(m_DepthMask));
+
+    m_Frame++;
+    collectReadbacks();
+    startReadback();
+    GLCall(glBindTexture(GL_TEXTURE_2D, texture));
+    GLCall(glActiveTexture(activeTexture));
+}
+
+/* Level 0 is the dilated raster, and each further level is drawn from the one above it. Limiting the texture to
+ * that level keeps the level being written out of what the shader can sample, which is what makes reading and
+ * writing one texture defined */
+void OcclusionCuller::buildHierarchy() {
+    m_EmptyVertexArray.bind();
+    GLCall(glDepthFunc(GL_ALWAYS));
+
+    m_DilateShader->bind();
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_RasterTexture));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_DepthTexture, 0));
+    GLState::get().viewport(0, 0, m_Width, m_Height);
+    GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+
+    m_DownsampleShader->bind();
+    GLCall(glBindTexture(GL_TEXTURE_2D, m_DepthTexture));
+    auto levelCount = (int) m_Levels.size();
+    for (int level = 1; level < levelCount; level++) {
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1));
+        GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1));
+        GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_DepthTexture, level));
+        GLState::get().viewport(0, 0, m_Levels[level].width, m_Levels[level].height);
+        GLCall(glDrawArrays(GL_TRIANGLES, 0, 3));
+    }
+
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_RasterTexture, 0));
+}
+
+/* Copies the chain into a free pixel buffer; the copy runs on the GPU's timeline and the fence tells when the
+ * buffer can be mapped without a stall. With every buffer still in flight the frame's chain is dropped */
+void OcclusionCuller::startReadback() {
+    Readback *target = nullptr;
+    for (Readback &readback: m_Readbacks) {
+        if (!readback.fence) {
+            target = &readback;
+            break;
+        }
+    }
+    if (!target)
+        return;
+
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, target->buffer));
+    for (size_t level = 0; level < m_Levels.size(); level++) {
+        GLCall(glGetTexImage(GL_TEXTURE_2D, (GLint) level, GL_DEPTH_COMPONENT, GL_FLOAT,
+                             (void *) (m_Levels[level].offset * sizeof(float))));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0)); /* Would otherwise redirect the caller's glReadPixels */
+
+    GLCall(target->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    target->frame = m_Frame;
+    mat4x4_dup(target->viewProjection, m_OccluderViewProjection);
+}
+
+void OcclusionCuller::collectReadbacks() {
+    Readback *newest = nullptr;
+    for (Readback &readback: m_Readbacks) {
+        if (!readback.fence)
+            continue;
+        GLCall(GLenum result = glClientWaitSync((GLsync) readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            continue;
+
+        GLCall(glDeleteSync((GLsync) readback.fence));
+        readback.fence = nullptr;
+        if (readback.frame > m_DepthFrame && (!newest || readback.frame > newest->frame))
+            newest = &readback;
+    }
+    if (!newest)
+        return;
+
+    m_Depths.resize(m_ChainSize);
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->buffer));
+    GLCall(const void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) (m_ChainSize * sizeof(float)),
+                                               GL_MAP_READ_BIT));
+    /* A failed map leaves nothing to unmap, and the previous chain stays in use */
+    if (data) {
+        memcpy(m_Depths.data(), data, m_ChainSize * sizeof(float));
+        m_DepthFrame = newest->frame;
+        mat4x4_dup(m_DepthViewProjection, newest->viewProjection);
+        GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+static inline float horizontalMin(float4 v) {
+    float lanes[4];
+    store4(lanes, v);
+    return std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+}
+
+static inline float horizontalMax(float4 v) {
+    float lanes[4];
+    store4(lanes, v);
+    return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+}
+
+/* Projects the box's corners into the chain's view and finds the level where the rectangle they span covers a
+ * few texels. The box is hidden if its nearest point lies behind the farthest depth in all of them */
+bool OcclusionCuller::isOccluded(const AABB &box) const {
+    if (!hasDepth())
+        return false;
+
+    /* Corner i takes min or max on each axis by bits 0, 1 and 2 of i. The clip coordinates of corners 0-3 and
+     * 4-7 are transposed so each register holds one coordinate of four corners */
+    float4 x[2] = {mul4(load4(m_DepthViewProjection[0]), broadcast4(box.min[0])),
+                   mul4(load4(m_DepthViewProjection[0]), broadcast4(box.max[0]))};
+    float4 y[2] = {mul4(load4(m_DepthViewProjection[1]), broadcast4(box.min[1])),
+                   mul4(load4(m_DepthViewProjection[1]), broadcast4(box.max[1]))};
+    float4 z[2] = {madd4(load4(m_DepthViewProjection[2]), broadcast4(box.min[2]), load4(m_DepthViewProjection[3])),
+                   madd4(load4(m_DepthViewProjection[2]), broadcast4(box.max[2]), load4(m_DepthViewProjection[3]))};
+
+    float4 minX = broadcast4(INFINITY), minY = minX, nearest = minX;
+    float4 maxX = broadcast4(-INFINITY), maxY = maxX;
+    for (int half = 0; half < 2; half++) {
+        float4 c0 = add4(add4(x[0], y[0]), z[half]), c1 = add4(add4(x[1], y[0]), z[half]);
+        float4 c2 = add4(add4(x[0], y[1]), z[half]), c3 = add4(add4(x[1], y[1]), z[half]);
+        transpose4(c0, c1, c2, c3);
+        if (lessMask4(c3, broadcast4(MIN_CLIP_W)))
+            return false;
+
+        float4 inverseW = div4(broadcast4(1.f), c3);
+        float4 ndcX = mul4(c0, inverseW), ndcY = mul4(c1, inverseW);
+        minX = min4(minX, ndcX);
+        maxX = max4(maxX, ndcX);
+        minY = min4(minY, ndcY);
+        maxY = max4(maxY, ndcY);
+        nearest = min4(nearest, mul4(c2, inverseW));
+    }
+
+    /* Window coordinates, in texels of level 0 and the [0, 1] depth range */
+    float left = (horizontalMin(minX) * 0.5f + 0.5f) * (float) m_Width;
+    float right = (horizontalMax(maxX) * 0.5f + 0.5f) * (float) m_Width;
+    float bottom = (horizontalMin(minY) * 0.5f + 0.5f) * (float) m_Height;
+    float top = (horizontalMax(maxY) * 0.5f + 0.5f) * (float) m_Height;
+    float depth = horizontalMin(nearest) * 0.5f + 0.5f - DEPTH_EPSILON;
+
+    /* Nothing is known about what lay outside the view the chain was drawn from */
+    if (!(left >= 0.f && bottom >= 0.f && right <= (float) m_Width && top <= (float) m_Height))
+        return false;
+
+    /* The smallest level whose texels are at least half as large as the rectangle, so at most 3x3 of them */
+    auto span = (unsigned int) std::ceil(std::max(right - left, top - bottom) * 0.5f);
+    int levelIndex = span <= 1 ? 0 : 32 - __builtin_clz(span - 1);
+    levelIndex = std::min(levelIndex, (int) m_Levels.size() - 1);
+    const Level &level = m_Levels[levelIndex];
+
+    /* A level's last texel also covers whatever the rounded-down sizes left over past it */
+    int x0 = std::min((int) left >> levelIndex, level.width - 1);
+    int x1 = std::min((int) right >> levelIndex, level.width - 1);
+    int y0 = std::min((int) bottom >> levelIndex, level.height - 1);
+    int y1 = std::min((int) top >> levelIndex, level.height - 1);
+    const float *depths = m_Depths.data() + level.offset;
+    for (int texelY = y0; texelY <= y1; texelY++) {
+        for (int texelX = x0; texelX <= x1; texelX++) {
+            if (depths[(size_t) texelY * level.width + texelX] >= depth)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool OcclusionCuller::isOccluded(const BoundingSphere &sphere) const {
+    if (!std::isfinite(sphere.radius))
+        return false;
+
+    const vec3 &c = sphere.center;
+    float r = sphere.radius;
+    return isOccluded(AABB{{c[0] - r, c[1] - r, c[2] - r}, {c[0] + r, c[1] + r, c[2] + r}});
+}
+
+size_t OcclusionCuller::cull(const AABB *bounds, size_t count, uint32_t *visible) const {
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!isOccluded(bounds[i]))
+            visible[written++] = (uint32_t) i;
+    }
+    return written;
+}
+
+size_t OcclusionCuller::cull(const BoundingSphere *bounds, size_t count, uint32_t *visible) const {
+    size_t written = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!isOccluded(bounds[i]))
+            visible[written++] = (uint32_t) i;
+    }
+    return written;
+}
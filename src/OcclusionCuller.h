@@ -0,0 +1,104 @@
+#ifndef OPENGL_OCCLUSIONCULLER_H
+#define OPENGL_OCCLUSIONCULLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Frustum.h"
+#include "VertexArray.h"
+
+class Shader;
+
+/* Occlusion culling against a hierarchical depth buffer. Large occluders are drawn into a small depth-only
+ * target between beginOccluders() and endOccluders(), which then reduces it to a mip chain where every texel
+ * holds the farthest depth of the texels under it, and reads the chain back through pixel buffers.
+ * Readbacks are collected a frame later rather than waited on, so draws are tested against the previous
+ * frame's occluders with the previous frame's view-projection; bounds reaching outside that view, or through
+ * its near plane, always pass. Occluders are rasterised at the culler's low resolution and then shrunk by a
+ * texel, so ones only a few texels across hide nothing */
+class OcclusionCuller {
+private:
+    static constexpr unsigned int READBACK_COUNT = 3;
+
+    struct Level {
+        int width;
+        int height;
+        size_t offset; /* In floats from the start of the chain */
+    };
+
+    struct Readback {
+        unsigned int buffer;
+        void *fence;    /* nullptr when the buffer is free */
+        uint64_t frame;
+        mat4x4 viewProjection;
+    };
+
+    int m_Width;
+    int m_Height;
+    std::vector<Level> m_Levels;
+    size_t m_ChainSize; /* Floats in all levels together */
+
+    unsigned int m_RasterTexture; /* Occluders are drawn here, then dilated into the chain's level 0 */
+    unsigned int m_DepthTexture;  /* The chain */
+    unsigned int m_Framebuffer;
+    std::unique_ptr<Shader> m_DilateShader;
+    std::unique_ptr<Shader> m_DownsampleShader;
+    VertexArray m_EmptyVertexArray; /* Core profile draws need some VAO bound */
+
+    Readback m_Readbacks[READBACK_COUNT];
+    uint64_t m_Frame = 0;
+    mat4x4 m_OccluderViewProjection;
+    /* The caller's state, put back by endOccluders() */
+    bool m_DepthTestEnabled = false;
+    int m_DepthFunc = 0;
+    unsigned char m_DepthMask = 1;
+    int m_Viewport[4] = {};
+    int m_DrawFramebuffer = 0;
+    int m_ReadFramebuffer = 0;
+
+    /* The newest chain read back, and the view-projection it was drawn with */
+    std::vector<float> m_Depths;
+    uint64_t m_DepthFrame = 0;
+    mat4x4 m_DepthViewProjection;
+
+    void buildHierarchy();
+    void startReadback();
+
+public:
+    /* [width] x [height] is the resolution occluders are drawn at, usually a fraction of the window's */
+    OcclusionCuller(int width, int height);
+    ~OcclusionCuller();
+
+    OcclusionCuller(const OcclusionCuller &) = delete;
+    OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+    /* Binds the occluder target with depth testing and writes on and cleared; draw the occluders with
+     * [viewProjection] in any program, their colour output is dropped. Leaves the viewport at the culler's size */
+    void beginOccluders(mat4x4 const viewProjection);
+    /* Builds the mip chain, queues its readback and puts back the framebuffers, viewport and depth state that
+     * were current at beginOccluders(), and the active texture unit and unit 0's 2D texture. The program and
+     * VAO it drew with stay bound; both went through GLState, so the next bind() of the caller's rebinds */
+    void endOccluders();
+    /* Takes in readbacks the GPU has finished. endOccluders() does this too; call it when occluders aren't
+     * drawn every frame. Never waits */
+    void collectReadbacks();
+
+    /* False until a readback has arrived, and then for anything that might be visible */
+    [[nodiscard]] bool isOccluded(const AABB &box) const;
+    [[nodiscard]] bool isOccluded(const BoundingSphere &sphere) const;
+
+    /* Writes the indices of the bounds that may be visible, in ascending order, to [visible], which needs room
+     * for [count]. Returns how many were written */
+    size_t cull(const AABB *bounds, size_t count, uint32_t *visible) const;
+    size_t cull(const BoundingSphere *bounds, size_t count, uint32_t *visible) const;
+
+    /* Whether there is a chain to test against, and which endOccluders() call it came from, counting from 1 */
+    inline bool hasDepth() const { return m_DepthFrame != 0; }
+    inline uint64_t getDepthFrame() const { return m_DepthFrame; }
+    inline unsigned int getDepthTexture() const { return m_DepthTexture; }
+    inline int getWidth() const { return m_Width; }
+    inline int getHeight() const { return m_Height; }
+};
+
+#endif //OPENGL_OCCLUSIONCULLER_H
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "ProgramBinaryCache.h"
+#include "GLExtensions.h"
+#include "Renderer.h"
+
+struct ProgramBinaryHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t sourceDigest;
+    uint32_t format;
+    uint32_t length;
+};
+
+static constexpr char PROGRAM_BINARY_MAGIC[4] = {'O', 'G', 'L', 'P'};
+static constexpr uint32_t PROGRAM_BINARY_VERSION = 2;
+
+/* 64-bit FNV-1a */
+static uint64_t hashBytes(uint64_t hash, std::string_view bytes) {
+    for (unsigned char byte: bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/* Each source's length goes in ahead of its bytes, so where one source ends and the next begins is part of
+ * the hash: moving text from the end of the vertex shader to the start of the fragment shader changes it */
+static uint64_t hashSource(uint64_t hash, std::string_view source) {
+    uint64_t length = source.size();
+    hash = hashBytes(hash, std::string_view((const char *) &length, sizeof(length)));
+    return hashBytes(hash, source);
+}
+
+/* SplitMix64 finaliser over 8-byte words, unrelated to FNV so the two hashes don't collide together */
+static uint64_t digestSource(uint64_t digest, std::string_view source) {
+    auto mix = [](uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+        value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+        return value ^ (value >> 31);
+    };
+    digest = mix(digest + source.size());
+    for (size_t i = 0; i < source.size(); i += 8) {
+        uint64_t word = 0;
+        memcpy(&word, source.data() + i, std::min<size_t>(8, source.size() - i));
+        digest = mix(digest ^ word) + 0x9e3779b97f4a7c15ull;
+    }
+    return digest;
+}
+
+ProgramBinaryCache::ProgramBinaryCache(std::filesystem::path directory) : m_Directory(std::move(directory)) {
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+}
+
+bool ProgramBinaryCache::isSupported() {
+    if (!GLAD_GL_ARB_get_program_binary)
+        return false;
+
+    int formats = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    return formats > 0;
+}
+
+ProgramBinaryKey ProgramBinaryCache::makeKey(const ShaderProgramSource &source) const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    hash = hashSource(hash, source.VertexSource);
+    hash = hashSource(hash, source.FragmentSource);
+    /* Binaries are only valid for the driver that produced them */
+    for (GLenum name: {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        GLCall(const char *value = (const char *) glGetString(name));
+        hash = hashBytes(hash, value ? value : "");
+    }
+    return {hash, digestSource(digestSource(0, source.VertexSource), source.FragmentSource)};
+}
+
+unsigned int ProgramBinaryCache::load(const ProgramBinaryKey &key) const {
+    if (!isSupported())
+        return 0;
+
+    std::ifstream stream(entryPath(key), std::ios::binary);
+    if (!stream)
+        return 0;
+
+    ProgramBinaryHeader header{};
+    if (!stream.read((char *) &header, sizeof(header)) ||
+        std::string_view(header.magic, 4) != std::string_view(PROGRAM_BINARY_MAGIC, 4) ||
+        header.version != PROGRAM_BINARY_VERSION || header.key != key.hash ||
+        header.sourceDigest != key.sourceDigest)
+        return 0;
+
+    std::vector<char> binary(header.length);
+    if (!stream.read(binary.data(), (std::streamsize) binary.size()))
+        return 0;
+
+    GLCall(unsigned int program = glCreateProgram());
+    /* A rejected binary raises no GL error, it just leaves the program unlinked */
+    GLCall(glProgramBinary(program, header.format, binary.data(), (GLsizei) binary.size()));
+
+    int linked;
+    GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (linked == GL_FALSE) {
+        GLCall(glDeleteProgram(program));
+        return 0;
+    }
+    return program;
+}
+
+void ProgramBinaryCache::store(const ProgramBinaryKey &key, unsigned int program) const {
+    if (!isSupported())
+        return;
+
+    int length = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    ProgramBinaryHeader header{};
+    std::copy(std::begin(PROGRAM_BINARY_MAGIC), std::end(PROGRAM_BINARY_MAGIC), header.magic);
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key.hash;
+    header.sourceDigest = key.sourceDigest;
+    header.format = format;
+    header.length = (uint32_t) length;
+
+    /* Write then rename, so a crash or a concurrent run never leaves a truncated entry behind */
+    std::filesystem::path path = entryPath(key);
+    std::filesystem::path temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        stream.write((const char *) &header, sizeof(header));
+        stream.write(binary.data(), length);
+        if (!stream) {
+            std::cout << "Warning: couldn't write program binary " << temporary << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+}
+
+std::filesystem::path ProgramBinaryCache::entryPath(const ProgramBinaryKey &key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) key.hash);
+    return m_Directory / name;
+}
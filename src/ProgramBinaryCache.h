@@ -0,0 +1,38 @@
+#ifndef OPENGL_PROGRAMBINARYCACHE_H
+#define OPENGL_PROGRAMBINARYCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include "Shader.h"
+
+/* Identifies a cache entry. [hash] also names the entry's file; [sourceDigest], a second and independent hash
+ * of the sources alone, is stored in the entry and compared on load, so a [hash] collision between two
+ * programs misses instead of loading the wrong binary */
+struct ProgramBinaryKey {
+    uint64_t hash;
+    uint64_t sourceDigest;
+};
+
+/* On-disk store of linked program binaries (glGetProgramBinary/glProgramBinary).
+ * Entries are keyed by a hash of the shader sources and the GL vendor/renderer/version strings,
+ * so a driver update or a source edit simply misses and the program is compiled from source again */
+class ProgramBinaryCache {
+private:
+    std::filesystem::path m_Directory;
+public:
+    explicit ProgramBinaryCache(std::filesystem::path directory);
+
+    /* Needs ARB_get_program_binary and at least one binary format from the driver */
+    [[nodiscard]] static bool isSupported();
+
+    [[nodiscard]] ProgramBinaryKey makeKey(const ShaderProgramSource &source) const;
+
+    /* Returns a linked program, or 0 if there is no entry or the driver rejects it */
+    [[nodiscard]] unsigned int load(const ProgramBinaryKey &key) const;
+    void store(const ProgramBinaryKey &key, unsigned int program) const;
+
+private:
+    [[nodiscard]] std::filesystem::path entryPath(const ProgramBinaryKey &key) const;
+};
+
+#endif //OPENGL_PROGRAMBINARYCACHE_H
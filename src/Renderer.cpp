@@ -1,5 +1,22 @@
 #include "Renderer.h"
+#include "GeometryArena.h"
+#include "GLExtensions.h"
+#include "OcclusionCuller.h"
+#include "StreamBuffer.h"
+#include "VertexBuffer.h"
+#include "VertexArrayCache.h"
+#include "VertexPuller.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+
+/* Room for roughly three frames of 65536 indirect draws before the ring has to wait on a fence */
+static constexpr unsigned int INDIRECT_BUFFER_SIZE = 4 * 1024 * 1024;
+static constexpr unsigned int MAX_INDIRECT_BATCH = 65536;
+
+/* Bounds for draws submitted without any: an infinite sphere, which every plane test passes */
+static constexpr BoundingSphere UNBOUNDED = {{0.f, 0.f, 0.f}, INFINITY};
 
 void GLClearError() {
     while (glGetError() != GL_NO_ERROR);
@@ -13,15 +30,502 @@ bool GLLogCall(const char *function, const char *file, int line) {
     return true;
 }
 
+static const char *debugSeverityName(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH:
+            return "high";
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            return "medium";
+        case GL_DEBUG_SEVERITY_LOW:
+            return "low";
+        default:
+            return "notification";
+    }
+}
+
+static const char *debugTypeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR:
+            return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+            return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+            return "undefined behaviour";
+        case GL_DEBUG_TYPE_PORTABILITY:
+            return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            return "performance";
+        case GL_DEBUG_TYPE_MARKER:
+            return "marker";
+        default:
+            return "other";
+    }
+}
+
+static void GLAD_API_PTR GLDebugMessageCallback(GLenum, GLenum type, GLuint id, GLenum severity, GLsizei,
+                                                const GLchar *message, const void *) {
+    std::cout << "[OpenGL " << debugTypeName(type) << ", " << debugSeverityName(severity) << " severity:]" << "("
+              << id << "): " << message << std::endl;
+}
+
+bool GLEnableDebugOutput() {
+    if (!GLAD_GL_KHR_debug || !glDebugMessageCallback)
+        return false;
+
+    GLCall(glEnable(GL_DEBUG_OUTPUT));
+#ifndef NDEBUG
+    /* Synchronous output lets a breakpoint in the callback land on the offending call */
+    GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+#else
+    GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+#endif
+    GLCall(glDebugMessageCallback(GLDebugMessageCallback, nullptr));
+    /* Notifications (buffer placement hints and the like) are too chatty to be useful */
+    GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE));
+    return true;
+}
+
+Renderer::Renderer() : m_VertexArrays(std::make_unique<VertexArrayCache>()) {
+}
+
+Renderer::~Renderer() = default;
+
+const Shader *Renderer::resolveShader(const Shader &shader) const {
+    if (shader.isReady())
+        return &shader;
+    if (m_FallbackShader && m_FallbackShader->isReady())
+        return m_FallbackShader;
+    return nullptr;
+}
+
 void Renderer::draw(const VertexArray &vertexArray, const IndexBuffer &indexBuffer, const Shader &shader) {
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return;
 
-    shader.bind();
+    program->bind();
     vertexArray.bind();
     indexBuffer.bind();
 
-    GLCall(glDrawElements(GL_TRIANGLES, indexBuffer.getCount(), GL_UNSIGNED_INT, nullptr));
+    GLCall(glDrawElements(GL_TRIANGLES, indexBuffer.getCount(), indexBuffer.getType(), nullptr));
 }
 
 void Renderer::clear() const {
     GLCall(glClear(GL_COLOR_BUFFER_BIT)); /* Clear buffer */
 }
+
+void Renderer::drawInstanced(const VertexArray &vertexArray, const IndexBuffer &indexBuffer, const Shader &shader,
+                             unsigned int instanceCount) {
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return;
+
+    program->bind();
+    vertexArray.bind();
+    indexBuffer.bind();
+
+    GLCall(glDrawElementsInstanced(GL_TRIANGLES, indexBuffer.getCount(), indexBuffer.getType(), nullptr,
+                                   (GLsizei) instanceCount));
+}
+
+void Renderer::draw(const GeometryArena &arena, const MeshRange &mesh, const Shader &shader) {
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return;
+
+    program->bind();
+    arena.getVertexArray().bind();
+
+    const IndexBuffer &indexBuffer = arena.getIndexBuffer();
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, indexBuffer.getType(),
+                                    (const void *) ((uintptr_t) mesh.firstIndex * indexBuffer.getIndexSize()),
+                                    mesh.baseVertex));
+}
+
+void Renderer::draw(const VertexBuffer &vertexBuffer, const VertexBufferLayout &layout,
+                    const IndexBuffer &indexBuffer, const Shader &shader) {
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return;
+
+    program->bind();
+    m_VertexArrays->bind(vertexBuffer, layout, indexBuffer);
+
+    GLCall(glDrawElements(GL_TRIANGLES, indexBuffer.getCount(), indexBuffer.getType(), nullptr));
+}
+
+void Renderer::drawPulled(const VertexPuller &puller, const PulledMesh *meshes, unsigned int count,
+                          const Shader &shader) {
+    const Shader *program = resolveShader(shader);
+    if (!program || count == 0)
+        return;
+
+    program->bind();
+    puller.bind(0);
+
+    m_Firsts.resize(count);
+    m_Counts.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        m_Firsts[i] = (int) meshes[i].firstIndex;
+        m_Counts[i] = (int) meshes[i].indexCount;
+    }
+    GLCall(glMultiDrawArrays(GL_TRIANGLES, m_Firsts.data(), m_Counts.data(), (GLsizei) count));
+}
+
+void Renderer::drawArrays(const VertexArray &vertexArray, const Shader &shader, unsigned int mode, int first,
+                          int count) {
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return;
+
+    program->bind();
+    vertexArray.bind();
+
+    GLCall(glDrawArrays(mode, first, count));
+}
+
+unsigned int Renderer::storeTransform(const mat4x4 *transform) {
+    if (!transform)
+        return NO_DRAW_TRANSFORM;
+
+    /* Without a uniform to load it into, the draw would silently use whatever matrix was set last */
+    ASSERT(!m_TransformUniform.empty());
+    DrawTransform &stored = m_DrawTransforms.emplace_back();
+    mat4x4_dup(stored.matrix, *transform);
+    return (unsigned int) m_DrawTransforms.size() - 1;
+}
+
+unsigned int Renderer::submit(const VertexArray &vertexArray, const IndexBuffer &indexBuffer, const Shader &shader,
+                              uint16_t material, float depth, const BoundingSphere *bounds,
+                              const mat4x4 *transform) {
+    /* IDs are handed out even for skipped draws so they keep matching the caller's per-draw data */
+    unsigned int drawID = m_NextDrawID++;
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return drawID;
+
+    uint64_t key = makeSortKey(program->getRendererID(), vertexArray.getRendererID(), material, depth);
+    m_CommandQueue.push_back({key, &vertexArray, &indexBuffer, program, indexBuffer.getCount(), 0, 0, drawID,
+                              storeTransform(transform)});
+    m_CommandBounds.push_back(bounds ? *bounds : UNBOUNDED);
+    return drawID;
+}
+
+unsigned int Renderer::submit(const GeometryArena &arena, const MeshRange &mesh, const Shader &shader,
+                              uint16_t material, float depth, const BoundingSphere *bounds,
+                              const mat4x4 *transform) {
+    unsigned int drawID = m_NextDrawID++;
+    const Shader *program = resolveShader(shader);
+    if (!program)
+        return drawID;
+
+    const VertexArray &vertexArray = arena.getVertexArray();
+    uint64_t key = makeSortKey(program->getRendererID(), vertexArray.getRendererID(), material, depth);
+    m_CommandQueue.push_back({key, &vertexArray, &arena.getIndexBuffer(), program,
+                              mesh.indexCount, mesh.firstIndex, (int) mesh.baseVertex, drawID,
+                              storeTransform(transform)});
+    m_CommandBounds.push_back(bounds ? *bounds : UNBOUNDED);
+    return drawID;
+}
+
+void Renderer::setCullFrustum(const Frustum *frustum) {
+    if (frustum)
+        m_CullFrustum = *frustum;
+    else
+        m_CullFrustum.reset();
+}
+
+/* Compacts the queue to the draws whose bounds touch the frustum and aren't hidden behind occluders. The
+ * visible indices come out ascending, so every kept command moves down or stays put */
+void Renderer::cullCommands() {
+    m_CulledCount = 0;
+    m_OccludedCount = 0;
+    if ((!m_CullFrustum && !m_OcclusionCuller) || m_CommandQueue.empty())
+        return;
+
+    size_t count = m_CommandQueue.size();
+    m_VisibleCommands.resize(count);
+    size_t visible = count;
+    if (m_CullFrustum)
+        visible = m_CullFrustum->cull(m_CommandBounds.data(), count, m_VisibleCommands.data());
+    else
+        std::iota(m_VisibleCommands.begin(), m_VisibleCommands.end(), 0u);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < visible; i++) {
+        uint32_t index = m_VisibleCommands[i];
+        if (m_OcclusionCuller && m_OcclusionCuller->isOccluded(m_CommandBounds[index]))
+            continue;
+        m_CommandQueue[kept++] = m_CommandQueue[index];
+    }
+    m_OccludedCount = (unsigned int) (visible - kept);
+    m_CulledCount = (unsigned int) (count - kept);
+    m_CommandQueue.resize(kept);
+}
+
+/* LSD radix sort of (key, index) pairs on 8-bit digits, stable and linear in the queue length. Digits that
+ * every key shares, usually the program and VAO bytes, get no pass, and an already sorted queue gets none */
+void Renderer::sortCommands() {
+    size_t count = m_CommandQueue.size();
+    m_SortEntries.resize(count);
+    m_SortScratch.resize(count);
+    if (count == 0)
+        return;
+
+    uint64_t firstKey = m_CommandQueue[0].sortKey;
+    uint64_t differingBits = 0;
+    bool sorted = true;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t key = m_CommandQueue[i].sortKey;
+        m_SortEntries[i] = {key, (uint32_t) i};
+        differingBits |= key ^ firstKey;
+        sorted &= i == 0 || key >= m_SortEntries[i - 1].key;
+    }
+    if (sorted)
+        return;
+
+    SortEntry *source = m_SortEntries.data();
+    SortEntry *destination = m_SortScratch.data();
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        if (((differingBits >> shift) & 0xFF) == 0)
+            continue;
+
+        uint32_t histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+            histogram[(source[i].key >> shift) & 0xFF]++;
+        uint32_t offset = 0;
+        for (uint32_t &bucket: histogram) {
+            uint32_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (size_t i = 0; i < count; i++)
+            destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+        std::swap(source, destination);
+    }
+    if (source != m_SortEntries.data())
+        m_SortEntries.swap(m_SortScratch);
+}
+
+void Renderer::flush() {
+    cullCommands();
+    sortCommands();
+
+    /* A non-zero baseInstance, which carries the draw ID, needs ARB_base_instance on top of MDI */
+    bool indirect = GLAD_GL_ARB_multi_draw_indirect && (m_DrawIDLocation < 0 || GLAD_GL_ARB_base_instance);
+    if (indirect) {
+        if (!m_IndirectBuffer)
+            m_IndirectBuffer = std::make_unique<StreamBuffer>(GL_DRAW_INDIRECT_BUFFER, INDIRECT_BUFFER_SIZE);
+        m_IndirectBuffer->bind();
+        if (m_DrawIDLocation >= 0)
+            reserveDrawIDs(m_NextDrawID);
+    }
+
+    const Shader *boundShader = nullptr;
+    const VertexArray *boundVertexArray = nullptr;
+    const IndexBuffer *boundIndexBuffer = nullptr;
+
+    size_t first = 0;
+    while (first < m_SortEntries.size()) {
+        const RenderCommand &command = m_CommandQueue[m_SortEntries[first].index];
+        size_t last = first + 1;
+        while (last < m_SortEntries.size() && command.transform == NO_DRAW_TRANSFORM) {
+            const RenderCommand &next = m_CommandQueue[m_SortEntries[last].index];
+            if (next.shader != command.shader || next.vertexArray != command.vertexArray ||
+                next.indexBuffer != command.indexBuffer || next.transform != NO_DRAW_TRANSFORM)
+                break;
+            last++;
+        }
+
+        if (command.shader != boundShader) {
+            command.shader->bind();
+            boundShader = command.shader;
+        }
+        if (command.vertexArray != boundVertexArray) {
+            if (boundVertexArray && indirect && m_DrawIDLocation >= 0)
+                detachDrawIDs();
+            command.vertexArray->bind();
+            boundVertexArray = command.vertexArray;
+            boundIndexBuffer = nullptr; /* Element buffer binding is part of the VAO state */
+            if (indirect && m_DrawIDLocation >= 0)
+                attachDrawIDs();
+        }
+        if (command.indexBuffer != boundIndexBuffer) {
+            command.indexBuffer->bind();
+            boundIndexBuffer = command.indexBuffer;
+        }
+
+        if (command.transform != NO_DRAW_TRANSFORM) {
+            drawTransformed(command, indirect);
+        } else {
+            restoreTransform(command.shader);
+            if (indirect)
+                drawIndirect(&m_SortEntries[first], (unsigned int) (last - first));
+            else
+                drawMulti(&m_SortEntries[first], (unsigned int) (last - first));
+        }
+        first = last;
+    }
+    if (boundVertexArray && indirect && m_DrawIDLocation >= 0)
+        detachDrawIDs();
+    for (const SavedTransform &saved: m_SavedTransforms) {
+        if (saved.overwritten) {
+            saved.shader->bind();
+            restoreTransform(saved.shader);
+        }
+    }
+    m_SavedTransforms.clear();
+
+    if (indirect)
+        m_IndirectBuffer->endFrame();
+    m_CommandQueue.clear(); /* Keeps capacity, so steady-state frames don't reallocate */
+    m_CommandBounds.clear();
+    m_DrawTransforms.clear();
+    m_NextDrawID = 0;
+}
+
+void Renderer::reserveDrawIDs(unsigned int count) {
+    if (count <= m_DrawIDCapacity)
+        return;
+
+    m_DrawIDCapacity = std::max({count, m_DrawIDCapacity * 2, 1024u});
+    std::vector<unsigned int> drawIDs(m_DrawIDCapacity);
+    std::iota(drawIDs.begin(), drawIDs.end(), 0u);
+    m_DrawIDBuffer = std::make_unique<VertexBuffer>(drawIDs.data(), m_DrawIDCapacity * sizeof(unsigned int));
+}
+
+/* Points the bound VAO's draw ID attribute at the 0, 1, 2... buffer. Redone on every VAO change rather than
+ * remembered per VAO, since the buffer is replaced when it grows and VAO names get reused; detachDrawIDs()
+ * undoes it before flush() moves on, so the caller's VAOs never keep reading the renderer's buffer */
+void Renderer::attachDrawIDs() const {
+    m_DrawIDBuffer->bind();
+    GLCall(glEnableVertexAttribArray(m_DrawIDLocation));
+    GLCall(glVertexAttribIPointer(m_DrawIDLocation, 1, GL_UNSIGNED_INT, 0, nullptr));
+    GLCall(glVertexAttribDivisor(m_DrawIDLocation, 1));
+}
+
+void Renderer::detachDrawIDs() const {
+    GLCall(glDisableVertexAttribArray(m_DrawIDLocation));
+    GLCall(glVertexAttribDivisor(m_DrawIDLocation, 0));
+}
+
+void Renderer::drawIndirect(const SortEntry *entries, unsigned int count) {
+    const IndexBuffer &indexBuffer = *m_CommandQueue[entries->index].indexBuffer;
+    bool drawIDs = m_DrawIDLocation >= 0;
+
+    while (count > 0) {
+        unsigned int batch = std::min(count, MAX_INDIRECT_BATCH);
+        StreamAllocation allocation = m_IndirectBuffer->allocate(batch * sizeof(DrawElementsIndirectCommand));
+        if (!allocation.data) {
+            /* This flush has already filled the ring, with no older frame's fence to wait on, so the batch
+             * goes out without it. Draw IDs are attached as an instanced array here, hence base instances */
+            if (drawIDs) {
+                unsigned int indexSize = indexBuffer.getIndexSize();
+                for (unsigned int i = 0; i < batch; i++) {
+                    const RenderCommand &command = m_CommandQueue[entries[i].index];
+                    GLCall(glDrawElementsInstancedBaseVertexBaseInstance(
+                            GL_TRIANGLES, (GLsizei) command.indexCount, indexBuffer.getType(),
+                            (const void *) ((uintptr_t) command.firstIndex * indexSize), 1, command.baseVertex,
+                            command.drawID));
+                }
+            } else {
+                drawMulti(entries, batch);
+            }
+            entries += batch;
+            count -= batch;
+            continue;
+        }
+        auto *indirect = (DrawElementsIndirectCommand *) allocation.data;
+        for (unsigned int i = 0; i < batch; i++) {
+            const RenderCommand &command = m_CommandQueue[entries[i].index];
+            indirect[i] = {command.indexCount, 1, command.firstIndex, command.baseVertex,
+                           drawIDs ? command.drawID : 0};
+        }
+        m_IndirectBuffer->commit();
+
+        GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, indexBuffer.getType(),
+                                           (const void *) (uintptr_t) allocation.offset, (GLsizei) batch, 0));
+        entries += batch;
+        count -= batch;
+    }
+}
+
+/* One draw with its own transform loaded first. With MDI on, the draw ID attribute is an enabled divisor-1
+ * array, so the ID goes in as the base instance as it would in an indirect command */
+void Renderer::drawTransformed(const RenderCommand &command, bool indirect) {
+    int location = command.shader->getUniformLocation(m_TransformUniform);
+    if (location >= 0) {
+        auto saved = std::find_if(m_SavedTransforms.begin(), m_SavedTransforms.end(),
+                                  [&](const SavedTransform &entry) { return entry.shader == command.shader; });
+        if (saved == m_SavedTransforms.end()) {
+            saved = m_SavedTransforms.insert(saved, {command.shader, location, false, {}});
+            GLCall(glGetUniformfv(command.shader->getRendererID(), location, (float *) saved->matrix));
+        }
+        saved->overwritten = true;
+        const DrawTransform &transform = m_DrawTransforms[command.transform];
+        GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, (const float *) transform.matrix));
+    }
+
+    const IndexBuffer &indexBuffer = *command.indexBuffer;
+    auto *offset = (const void *) ((uintptr_t) command.firstIndex * indexBuffer.getIndexSize());
+    if (m_DrawIDLocation >= 0 && indirect) {
+        GLCall(glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, (GLsizei) command.indexCount,
+                                                             indexBuffer.getType(), offset, 1, command.baseVertex,
+                                                             command.drawID));
+        return;
+    }
+    if (m_DrawIDLocation >= 0) {
+        GLCall(glVertexAttribI1ui(m_DrawIDLocation, command.drawID));
+    }
+    GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei) command.indexCount, indexBuffer.getType(), offset,
+                                    command.baseVertex));
+}
+
+void Renderer::restoreTransform(const Shader *shader) {
+    for (SavedTransform &saved: m_SavedTransforms) {
+        if (saved.shader == shader && saved.overwritten) {
+            GLCall(glUniformMatrix4fv(saved.location, 1, GL_FALSE, (const float *) saved.matrix));
+            saved.overwritten = false;
+        }
+    }
+}
+
+void Renderer::drawMulti(const SortEntry *entries, unsigned int count) {
+    const IndexBuffer &indexBuffer = *m_CommandQueue[entries->index].indexBuffer;
+    unsigned int indexSize = indexBuffer.getIndexSize();
+
+    /* The attribute's current value is only read while its array is disabled, which it is on this path */
+    if (m_DrawIDLocation >= 0) {
+        for (unsigned int i = 0; i < count; i++) {
+            const RenderCommand &command = m_CommandQueue[entries[i].index];
+            GLCall(glVertexAttribI1ui(m_DrawIDLocation, command.drawID));
+            GLCall(glDrawElementsBaseVertex(GL_TRIANGLES, command.indexCount, indexBuffer.getType(),
+                                            (const void *) ((uintptr_t) command.firstIndex * indexSize),
+                                            command.baseVertex));
+        }
+        return;
+    }
+
+    m_Counts.resize(count);
+    m_Offsets.resize(count);
+    m_BaseVertices.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        const RenderCommand &command = m_CommandQueue[entries[i].index];
+        m_Counts[i] = (int) command.indexCount;
+        m_Offsets[i] = (const void *) ((uintptr_t) command.firstIndex * indexSize);
+        m_BaseVertices[i] = command.baseVertex;
+    }
+    GLCall(glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_Counts.data(), indexBuffer.getType(), m_Offsets.data(),
+                                         (GLsizei) count, m_BaseVertices.data()));
+}
+
+uint64_t Renderer::makeSortKey(unsigned int program, unsigned int vertexArray, uint16_t material, float depth) {
+    /* Depth is expected in [0, 1]; smaller values sort first, giving front-to-back order within a state group */
+    float clamped = std::clamp(depth, 0.f, 1.f);
+    auto quantisedDepth = (uint64_t) (clamped * 65535.f);
+
+    return ((uint64_t) (program & 0xFFFF) << 48) |
+           ((uint64_t) (vertexArray & 0xFFFF) << 32) |
+           ((uint64_t) material << 16) |
+           quantisedDepth;
+}
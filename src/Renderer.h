@@ -1,23 +1,200 @@
 #ifndef OPENGL_RENDERER_H
 #define OPENGL_RENDERER_H
 
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 #include "glad/gl.h"
+#include "Frustum.h"
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
 
 #define ASSERT(x) if (!(x)) __builtin_debugtrap()
+
+/* GLCALL_CHECKS (CMake option OPENGL_GLCALL_CHECKS) polls glGetError around every call, which costs a
+ * driver round trip each time; without it GLCall is the bare call and GLEnableDebugOutput() reports errors */
+#ifdef GLCALL_CHECKS
 #define GLCall(x) GLClearError(); x; ASSERT(GLLogCall(#x, __FILE_NAME__, __LINE__))
+#else
+#define GLCall(x) x
+#endif
 
 void GLClearError();
 
 bool GLLogCall(const char *function, const char *file, int line);
 
+/* Installs a GL_KHR_debug message callback; synchronous (reported inside the failing call) unless NDEBUG.
+ * Returns false when the context doesn't expose KHR_debug */
+bool GLEnableDebugOutput();
+
+class GeometryArena;
+struct MeshRange;
+class OcclusionCuller;
+class StreamBuffer;
+class VertexBuffer;
+class VertexBufferLayout;
+class VertexArrayCache;
+class VertexPuller;
+struct PulledMesh;
+
+/* A queued draw's own transform, copied at submit() time */
+struct DrawTransform {
+    mat4x4 matrix;
+};
+
+/* A queued draw; sortKey packs (program, VAO, material, depth) from most to least significant 16 bits
+ * so that sorting the queue groups draws that share state */
+struct RenderCommand {
+    uint64_t sortKey;
+    const VertexArray *vertexArray;
+    const IndexBuffer *indexBuffer;
+    const Shader *shader;
+    unsigned int indexCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int drawID;
+    unsigned int transform; /* Into Renderer's per-draw transforms, NO_DRAW_TRANSFORM for none */
+};
+
+static constexpr unsigned int NO_DRAW_TRANSFORM = ~0u;
+
+/* Layout fixed by GL for glMultiDrawElementsIndirect */
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
 class Renderer {
 private:
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index; /* Into m_CommandQueue */
+    };
+
+    std::vector<RenderCommand> m_CommandQueue;
+    std::vector<BoundingSphere> m_CommandBounds; /* Parallel to m_CommandQueue */
+    std::vector<DrawTransform> m_DrawTransforms;
+    std::string m_TransformUniform;
+
+    /* The caller's value of the transform uniform in each program that transformed draws overwrote during
+     * flush(); put back before that program's other draws and once flush() is done */
+    struct SavedTransform {
+        const Shader *shader;
+        int location;
+        bool overwritten;
+        mat4x4 matrix;
+    };
+    std::vector<SavedTransform> m_SavedTransforms;
+    std::vector<uint32_t> m_VisibleCommands;
+    std::optional<Frustum> m_CullFrustum;
+    const OcclusionCuller *m_OcclusionCuller = nullptr;
+    unsigned int m_CulledCount = 0;
+    unsigned int m_OccludedCount = 0;
+    std::vector<SortEntry> m_SortEntries;
+    std::vector<SortEntry> m_SortScratch;
+    const Shader *m_FallbackShader = nullptr;
+    unsigned int m_NextDrawID = 0;
+
+    /* Multi-draw state: commands are written to m_IndirectBuffer when MDI is available, otherwise into the
+     * arrays below for glMultiDrawElementsBaseVertex */
+    int m_DrawIDLocation = -1;
+    std::unique_ptr<StreamBuffer> m_IndirectBuffer;
+    std::unique_ptr<VertexBuffer> m_DrawIDBuffer;
+    unsigned int m_DrawIDCapacity = 0;
+    std::vector<int> m_Counts;
+    std::vector<const void *> m_Offsets;
+    std::vector<int> m_BaseVertices;
+    std::vector<int> m_Firsts;
+
+    std::unique_ptr<VertexArrayCache> m_VertexArrays;
+
+    [[nodiscard]] const Shader *resolveShader(const Shader &shader) const;
+    void reserveDrawIDs(unsigned int count);
+    void attachDrawIDs() const;
+    void detachDrawIDs() const;
+    void cullCommands();
+    void sortCommands();
+    void drawIndirect(const SortEntry *entries, unsigned int count);
+    void drawMulti(const SortEntry *entries, unsigned int count);
+    void drawTransformed(const RenderCommand &command, bool indirect);
+    /* Needs [shader] bound */
+    void restoreTransform(const Shader *shader);
+    unsigned int storeTransform(const mat4x4 *transform);
 public:
+    Renderer();
+    ~Renderer();
+
+    Renderer(const Renderer &) = delete;
+    Renderer &operator=(const Renderer &) = delete;
+
     void clear() const;
+
+    /* Draws whose shader is still compiling use this program instead, or are skipped if there is none.
+     * Its uniforms are set by the caller like any other program's */
+    void setFallbackShader(const Shader *shader) { m_FallbackShader = shader; }
     void draw(const VertexArray& vertexArray, const IndexBuffer& indexBuffer, const Shader& shader);
+    void draw(const GeometryArena& arena, const MeshRange& mesh, const Shader& shader);
+    /* Without a VertexArray of the caller's: the VAO comes from getVertexArrayCache() */
+    void draw(const VertexBuffer& vertexBuffer, const VertexBufferLayout& layout, const IndexBuffer& indexBuffer,
+              const Shader& shader);
+    /* [instanceCount] copies in one call; per-instance attributes come from buffers added to the VAO with a
+     * non-zero divisor in their layout */
+    void drawInstanced(const VertexArray& vertexArray, const IndexBuffer& indexBuffer, const Shader& shader,
+                       unsigned int instanceCount);
+    /* Any number of pulled meshes, whatever their formats, in one glMultiDrawArrays. The puller's data is
+     * bound to texture unit 0, which is where a u_PulledVertices left at its default samples from */
+    void drawPulled(const VertexPuller& puller, const PulledMesh* meshes, unsigned int count, const Shader& shader);
+    /* Non-indexed draw, e.g. of per-frame geometry in a StreamBuffer starting at vertex [first] */
+    void drawArrays(const VertexArray& vertexArray, const Shader& shader, unsigned int mode, int first, int count);
+
+    /* Deferred submission: draws are queued here and issued by flush() in sort key order.
+     * Uniforms are read from the program when flush() runs, not when the draw is submitted, except for a
+     * [transform]: it is copied now and loaded into the uniform named by setTransformUniform() just before the
+     * draw, so every queued object keeps its own matrix. Transformed draws are issued one by one.
+     * Returns the draw's ID, its index in submission order since the last flush(), for indexing per-draw data.
+     * Draws given [bounds], in world space, are dropped by flush() when they lie outside the cull frustum or
+     * behind the occlusion culler's occluders */
+    unsigned int submit(const VertexArray& vertexArray, const IndexBuffer& indexBuffer, const Shader& shader,
+                        uint16_t material = 0, float depth = 0.f, const BoundingSphere* bounds = nullptr,
+                        const mat4x4* transform = nullptr);
+    /* Meshes sharing an arena share its VAO, so consecutive ones in the sorted queue need no rebinding */
+    unsigned int submit(const GeometryArena& arena, const MeshRange& mesh, const Shader& shader,
+                        uint16_t material = 0, float depth = 0.f, const BoundingSphere* bounds = nullptr,
+                        const mat4x4* transform = nullptr);
+    /* Consecutive queued draws with the same program, VAO and index buffer are issued as one
+     * glMultiDrawElementsIndirect (GL 4.3 / ARB_multi_draw_indirect), or one glMultiDrawElementsBaseVertex */
+    void flush();
+
+    /* Feeds each queued draw's ID to the `in uint` attribute at [location] (-1 to disable).
+     * With MDI the ID rides in baseInstance and is read back through a divisor-1 attribute of 0, 1, 2...;
+     * without it the run is split into single draws that set the attribute's current value. No layout may use
+     * [location]; flush() attaches the array to each VAO it draws and disables it again afterwards */
+    void setDrawIDLocation(int location) { m_DrawIDLocation = location; }
+
+    /* The mat4 uniform, e.g. "u_MVP", that submitted transforms are loaded into. Must be set before any draw
+     * is submitted with a transform; programs without the uniform ignore it */
+    void setTransformUniform(std::string name) { m_TransformUniform = std::move(name); }
+
+    /* Queued draws with bounds are tested against this frustum before sorting; nullptr turns culling off.
+     * The frustum is copied, so set it again whenever the camera moves */
+    void setCullFrustum(const Frustum* frustum);
+    /* Queued draws with bounds that pass the frustum are then tested against the culler's depth chain;
+     * nullptr turns occlusion culling off. The culler is not copied and must outlive its use here */
+    void setOcclusionCuller(const OcclusionCuller* culler) { m_OcclusionCuller = culler; }
+    /* Draws dropped by the last flush(), and how many of those were behind occluders */
+    inline unsigned int getCulledCount() const { return m_CulledCount; }
+    inline unsigned int getOccludedCount() const { return m_OccludedCount; }
+
+    /* Destroying a buffer drops the cache's VAOs that reference it */
+    VertexArrayCache &getVertexArrayCache() { return *m_VertexArrays; }
+
+    static uint64_t makeSortKey(unsigned int program, unsigned int vertexArray, uint16_t material, float depth);
 };
 
 #endif //OPENGL_RENDERER_H
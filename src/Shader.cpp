@@ -4,34 +4,138 @@
 #include "Shader.h"
 #include "glad/gl.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "GLExtensions.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderCompiler.h"
 
-Shader::Shader(const std::string &filepath) : m_Filepath(filepath), m_RendererID(0) {
-    const auto[vertex_shader_text, fragment_shader_text] =
-    parseShader(filepath);
-    m_RendererID = createShader(vertex_shader_text, fragment_shader_text);
+Shader::Shader(const std::string &filepath, const ProgramBinaryCache *binaryCache) :
+    m_Filepath(filepath), m_RendererID(0) {
+    m_RendererID = createShader(parseShader(filepath), binaryCache);
+}
+
+Shader::Shader(const std::string &filepath, ShaderCompiler &compiler, const ProgramBinaryCache *binaryCache) :
+    m_Filepath(filepath), m_RendererID(0) {
+    ShaderProgramSource source = parseShader(filepath);
+
+    /* Loading a cached binary is cheap enough to do right away */
+    ProgramBinaryKey key{};
+    if (binaryCache && ProgramBinaryCache::isSupported()) {
+        key = binaryCache->makeKey(source);
+        if ((m_RendererID = binaryCache->load(key)))
+            return;
+    } else {
+        binaryCache = nullptr;
+    }
+
+    m_CompileJob = compiler.submit(std::move(source), filepath, binaryCache, key);
+}
+
+Shader::Shader(const ShaderProgramSource &source, const std::string &name, const ProgramBinaryCache *binaryCache) :
+    m_Filepath(name), m_RendererID(0) {
+    m_RendererID = createShader(source, binaryCache);
 }
 
 Shader::~Shader() {
+    if (m_CompileJob)
+        ShaderCompiler::cancel(*m_CompileJob);
     GLCall(glDeleteProgram(m_RendererID));
+    GLState::get().onDeleteProgram(m_RendererID);
+}
+
+bool Shader::isReady() const {
+    if (m_CompileJob && ShaderCompiler::poll(*m_CompileJob)) {
+        m_RendererID = m_CompileJob->program;
+        m_CompileJob.reset();
+    }
+    return !m_CompileJob;
+}
+
+void Shader::waitUntilReady() const {
+    if (m_CompileJob) {
+        ShaderCompiler::wait(*m_CompileJob);
+        m_RendererID = m_CompileJob->program;
+        m_CompileJob.reset();
+    }
 }
 
 void Shader::bind() const {
-    GLCall(glUseProgram(m_RendererID));
+    waitUntilReady();
+    GLState::get().useProgram(m_RendererID);
 }
 
 void Shader::unBind() const {
-    GLCall(glUseProgram(0));
+    GLState::get().useProgram(0);
+}
+
+void Shader::setUniform1i(int location, int value) {
+    GLCall(glUniform1i(location, value));
+}
+
+void Shader::setUniform1f(int location, float value) {
+    GLCall(glUniform1f(location, value));
+}
+
+void Shader::setUniformVec2(int location, const vec2 vec) {
+    GLCall(glUniform2fv(location, 1, vec));
+}
+
+void Shader::setUniformVec3(int location, const vec3 vec) {
+    GLCall(glUniform3fv(location, 1, vec));
+}
+
+void Shader::setUniformVec4(int location, const vec4 vec) {
+    GLCall(glUniform4fv(location, 1, vec));
+}
+
+void Shader::setUniformMat3x3(int location, const float *mat) {
+    GLCall(glUniformMatrix3fv(location, 1, GL_FALSE, mat));
 }
 
 void Shader::setUniformMat4x4(int location, const mat4x4 mat) {
     GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, (const GLfloat *) mat));
 }
 
-int Shader::getUniformLocation(const std::string &name) const {
-    GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+void Shader::setUniform1i(std::string_view name, int value) {
+    setUniform1i(getUniformLocation(name), value);
+}
+
+void Shader::setUniform1f(std::string_view name, float value) {
+    setUniform1f(getUniformLocation(name), value);
+}
+
+void Shader::setUniformVec2(std::string_view name, const vec2 vec) {
+    setUniformVec2(getUniformLocation(name), vec);
+}
+
+void Shader::setUniformVec3(std::string_view name, const vec3 vec) {
+    setUniformVec3(getUniformLocation(name), vec);
+}
+
+void Shader::setUniformVec4(std::string_view name, const vec4 vec) {
+    setUniformVec4(getUniformLocation(name), vec);
+}
+
+void Shader::setUniformMat3x3(std::string_view name, const float *mat) {
+    setUniformMat3x3(getUniformLocation(name), mat);
+}
+
+void Shader::setUniformMat4x4(std::string_view name, const mat4x4 mat) {
+    setUniformMat4x4(getUniformLocation(name), mat);
+}
+
+int Shader::getUniformLocation(std::string_view name) const {
+    if (auto cached = m_UniformLocationCache.find(name); cached != m_UniformLocationCache.end())
+        return cached->second;
+
+    waitUntilReady();
+    /* Only a miss pays for the std::string, which also gives glGetUniformLocation its terminator */
+    std::string key(name);
+    GLCall(int location = glGetUniformLocation(m_RendererID, key.c_str()));
     if (location == -1) {
         std::cout << "Warning: uniform " << name << " doesn't exist!" << std::endl;
     }
+    m_UniformLocationCache.emplace(std::move(key), location); /* Missing names are cached too, warning once */
     return location;
 }
 
@@ -69,6 +173,10 @@ unsigned int Shader::compileShader(unsigned int type, const char *source) {
     glShaderSource(shader, 1, &source, nullptr);
     glCompileShader(shader);
 
+    return shader;
+}
+
+static bool checkCompileStatus(unsigned int shader, unsigned int type) {
     int result;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -81,37 +189,78 @@ unsigned int Shader::compileShader(unsigned int type, const char *source) {
                   << (type == GL_VERTEX_SHADER ? "Vertex" : "Fragment") << " Shader"
                   << std::endl;
         std::cout << message << std::endl;
+        return false;
+    }
+    return true;
+}
 
-        glDeleteShader(shader);
-        return 0;
+unsigned int Shader::createShader(const ShaderProgramSource &source, const ProgramBinaryCache *binaryCache) {
+
+    bool useCache = binaryCache && ProgramBinaryCache::isSupported();
+    ProgramBinaryKey key{};
+    if (useCache) {
+        key = binaryCache->makeKey(source);
+        if (unsigned int program = binaryCache->load(key))
+            return program;
     }
 
-    return shader;
+    return endCreateShader(beginCreateShader(source, useCache), m_Filepath, useCache ? binaryCache : nullptr, key);
 }
 
-
-unsigned int Shader::createShader(const std::string &vertex_text, const std::string &fragment_text) {
+PendingProgram Shader::beginCreateShader(const ShaderProgramSource &source, bool retrievable) {
 
     unsigned int vertex_shader, fragment_shader, program;
 
-    const char *vText = vertex_text.c_str();
-    const char *fText = fragment_text.c_str();
+    const char *vText = source.VertexSource.c_str();
+    const char *fText = source.FragmentSource.c_str();
     vertex_shader = compileShader(GL_VERTEX_SHADER, vText);
     fragment_shader = compileShader(GL_FRAGMENT_SHADER, fText);
 
     program = glCreateProgram();
+    if (retrievable)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
     glLinkProgram(program);
+
+    return {vertex_shader, fragment_shader, program};
+}
+
+unsigned int Shader::endCreateShader(const PendingProgram &pending, const std::string &name,
+                                     const ProgramBinaryCache *binaryCache, const ProgramBinaryKey &binaryKey) {
+
+    unsigned int program = pending.program;
+
+    checkCompileStatus(pending.vertexShader, GL_VERTEX_SHADER);
+    checkCompileStatus(pending.fragmentShader, GL_FRAGMENT_SHADER);
+
+    int result;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        int length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        char *message = (char *) alloca(length * sizeof(char));
+        glGetProgramInfoLog(program, length, &length, message);
+
+        std::cout << "Failed to link: " << name << std::endl;
+        std::cout << message << std::endl;
+    }
+#ifndef NDEBUG
+    /* Validation checks the program against the current state and is only informative during development */
     glValidateProgram(program);
+#endif
+
+    glDeleteShader(pending.vertexShader);
+    glDeleteShader(pending.fragmentShader);
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+    if (binaryCache && result == GL_TRUE)
+        binaryCache->store(binaryKey, program);
 
     return program;
 }
 
 int Shader::getAttributeLocation(const std::string &name) const {
+    waitUntilReady();
     GLCall(int location = glGetAttribLocation(m_RendererID, name.c_str()));
     if (location == -1) {
         std::cout << "Warning: attribute " << name << " doesn't exist!" << std::endl;
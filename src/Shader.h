@@ -1,7 +1,11 @@
 #ifndef OPENGL_SHADER_H
 #define OPENGL_SHADER_H
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include "linmath.h"
 
 struct ShaderProgramSource {
@@ -9,30 +13,84 @@ struct ShaderProgramSource {
     std::string FragmentSource;
 };
 
+/* GL objects of a program whose compile and link have been issued but whose status hasn't been read yet */
+struct PendingProgram {
+    unsigned int vertexShader;
+    unsigned int fragmentShader;
+    unsigned int program;
+};
+
+/* Lets the uniform cache be probed with a std::string_view without building a std::string */
+struct UniformNameHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+};
+
+class ProgramBinaryCache;
+struct ProgramBinaryKey;
+class ShaderCompiler;
+struct ShaderCompileJob;
+
 class Shader {
 private:
     std::string m_Filepath;
-    unsigned int m_RendererID;
+    mutable unsigned int m_RendererID; /* 0 until an asynchronous compile has finished */
+    mutable std::shared_ptr<ShaderCompileJob> m_CompileJob;
+    mutable std::unordered_map<std::string, int, UniformNameHash, std::equal_to<>> m_UniformLocationCache;
 
 public:
-    Shader(const std::string& filepath );
+    /* With a binary cache the linked program is loaded from disk when an entry matches, else compiled and stored */
+    Shader(const std::string& filepath, const ProgramBinaryCache *binaryCache = nullptr);
+    /* Returns as soon as the work is submitted; isReady() tells when the program can be used */
+    Shader(const std::string& filepath, ShaderCompiler& compiler, const ProgramBinaryCache *binaryCache = nullptr);
+    /* From sources already in memory, e.g. parseShader() output with generated code added; [name] is for logs */
+    Shader(const ShaderProgramSource& source, const std::string& name,
+           const ProgramBinaryCache *binaryCache = nullptr);
     ~Shader();
 
+    /* Non-blocking. Anything that needs the linked program (bind, location queries) waits for it instead */
+    [[nodiscard]] bool isReady() const;
+    void waitUntilReady() const;
+
     void bind() const;
     void unBind() const;
 
-    // set uniforms
+    inline unsigned int getRendererID() const { return m_RendererID; }
+
+    // set uniforms, either by location from getUniformLocation() or by name through the location cache
+    void setUniform1i(int location, int value);
+    void setUniform1f(int location, float value);
+    void setUniformVec2(int location, const vec2 vec);
+    void setUniformVec3(int location, const vec3 vec);
+    void setUniformVec4(int location, const vec4 vec);
+    void setUniformMat3x3(int location, const float *mat); /* 9 floats, column major */
     void setUniformMat4x4(int location, const mat4x4 mat);
-    [[nodiscard]] int getUniformLocation(const std::string& name) const;
+
+    void setUniform1i(std::string_view name, int value);
+    void setUniform1f(std::string_view name, float value);
+    void setUniformVec2(std::string_view name, const vec2 vec);
+    void setUniformVec3(std::string_view name, const vec3 vec);
+    void setUniformVec4(std::string_view name, const vec4 vec);
+    void setUniformMat3x3(std::string_view name, const float *mat);
+    void setUniformMat4x4(std::string_view name, const mat4x4 mat);
+
+    [[nodiscard]] int getUniformLocation(std::string_view name) const;
     [[nodiscard]] int getAttributeLocation(const std::string& name) const;
 
+    static ShaderProgramSource parseShader(const std::string &filePath);
+
 private:
 
-    ShaderProgramSource parseShader(const std::string &filePath);
+    unsigned int createShader(const ShaderProgramSource &source, const ProgramBinaryCache *binaryCache);
 
-    unsigned int compileShader(unsigned int type, const char *source);
+    /* The two halves of createShader, split so the status queries in the second one can be deferred */
+    static unsigned int compileShader(unsigned int type, const char *source);
+    static PendingProgram beginCreateShader(const ShaderProgramSource &source, bool retrievable);
+    static unsigned int endCreateShader(const PendingProgram &pending, const std::string &name,
+                                        const ProgramBinaryCache *binaryCache, const ProgramBinaryKey &binaryKey);
 
-    unsigned int createShader(const std::string &vertex_text, const std::string &fragment_text);
+    friend class ShaderCompiler;
 };
 
 #endif //OPENGL_SHADER_H
@@ -0,0 +1,173 @@
+#include "ShaderCompiler.h"
+#include "GLExtensions.h"
+#include "Renderer.h"
+
+ShaderCompiler::ShaderCompiler(std::function<void(bool current)> setWorkerContextCurrent) :
+    m_ParallelCompile(GLAD_GL_KHR_parallel_shader_compile),
+    m_SetWorkerContextCurrent(std::move(setWorkerContextCurrent)) {
+    if (m_ParallelCompile) {
+        /* Let the driver pick how many threads to use */
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    } else if (m_SetWorkerContextCurrent) {
+        m_Worker = std::thread(&ShaderCompiler::workerLoop, this);
+    }
+}
+
+ShaderCompiler::~ShaderCompiler() {
+    if (!m_Worker.joinable())
+        return;
+
+    {
+        std::lock_guard lock(m_QueueMutex);
+        m_Stopping = true;
+    }
+    m_QueueCondition.notify_one();
+    m_Worker.join();
+}
+
+std::shared_ptr<ShaderCompileJob> ShaderCompiler::submit(ShaderProgramSource source, const std::string &name,
+                                                         const ProgramBinaryCache *binaryCache,
+                                                         const ProgramBinaryKey &binaryKey) {
+    auto job = std::make_shared<ShaderCompileJob>();
+    job->source = std::move(source);
+    job->name = name;
+    job->binaryCache = binaryCache;
+    job->binaryKey = binaryKey;
+
+    if (m_ParallelCompile) {
+        /* Issue everything now; nothing queries a status until the driver reports completion */
+        job->pending = Shader::beginCreateShader(job->source, binaryCache != nullptr);
+    } else if (m_Worker.joinable()) {
+        {
+            std::lock_guard lock(m_QueueMutex);
+            m_Queue.push_back(job);
+        }
+        m_QueueCondition.notify_one();
+    } else {
+        job->program = Shader::endCreateShader(Shader::beginCreateShader(job->source, binaryCache != nullptr),
+                                               job->name, binaryCache, binaryKey);
+        job->finished = true;
+    }
+    return job;
+}
+
+bool ShaderCompiler::poll(ShaderCompileJob &job) {
+    if (job.pending.program) {
+        int completed;
+        GLCall(glGetProgramiv(job.pending.program, GL_COMPLETION_STATUS_KHR, &completed));
+        if (completed == GL_FALSE)
+            return false;
+
+        job.program = Shader::endCreateShader(job.pending, job.name, job.binaryCache, job.binaryKey);
+        job.pending = {};
+        job.finished = true;
+        return true;
+    }
+
+    std::lock_guard lock(job.mutex);
+    if (!job.finished)
+        return false;
+    if (job.fence) {
+        GLCall(GLenum status = glClientWaitSync((GLsync) job.fence, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED)
+            return false;
+        GLCall(glDeleteSync((GLsync) job.fence));
+        job.fence = nullptr;
+    }
+    return true;
+}
+
+void ShaderCompiler::wait(ShaderCompileJob &job) {
+    if (job.pending.program) {
+        /* The status queries in endCreateShader block until the driver is done */
+        job.program = Shader::endCreateShader(job.pending, job.name, job.binaryCache, job.binaryKey);
+        job.pending = {};
+        job.finished = true;
+        return;
+    }
+
+    std::unique_lock lock(job.mutex);
+    job.finishedCondition.wait(lock, [&job]() { return job.finished; });
+    if (job.fence) {
+        GLCall(glClientWaitSync((GLsync) job.fence, 0, GL_TIMEOUT_IGNORED));
+        GLCall(glDeleteSync((GLsync) job.fence));
+        job.fence = nullptr;
+    }
+}
+
+void ShaderCompiler::cancel(ShaderCompileJob &job) {
+    if (job.pending.program) {
+        GLCall(glDeleteShader(job.pending.vertexShader));
+        GLCall(glDeleteShader(job.pending.fragmentShader));
+        GLCall(glDeleteProgram(job.pending.program));
+        job.pending = {};
+        return;
+    }
+
+    std::lock_guard lock(job.mutex);
+    if (!job.finished) {
+        job.cancelled = true; /* The worker deletes what it builds */
+        return;
+    }
+    if (job.fence) {
+        GLCall(glDeleteSync((GLsync) job.fence));
+        job.fence = nullptr;
+    }
+    GLCall(glDeleteProgram(job.program));
+    job.program = 0;
+}
+
+void ShaderCompiler::workerLoop() {
+    m_SetWorkerContextCurrent(true);
+
+    while (true) {
+        std::shared_ptr<ShaderCompileJob> job;
+        {
+            std::unique_lock lock(m_QueueMutex);
+            m_QueueCondition.wait(lock, [this]() { return m_Stopping || !m_Queue.empty(); });
+            if (m_Stopping)
+                break;
+            job = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+
+        {
+            std::lock_guard lock(job->mutex);
+            if (job->cancelled)
+                continue;
+        }
+
+        unsigned int program = Shader::endCreateShader(
+                Shader::beginCreateShader(job->source, job->binaryCache != nullptr),
+                job->name, job->binaryCache, job->binaryKey);
+        /* The fence goes in this context's command stream; flushing makes it visible to the main context */
+        GLCall(GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        GLCall(glFlush());
+
+        {
+            std::lock_guard lock(job->mutex);
+            if (job->cancelled) {
+                GLCall(glDeleteSync(fence));
+                GLCall(glDeleteProgram(program));
+            } else {
+                job->program = program;
+                job->fence = fence;
+            }
+            job->finished = true;
+        }
+        job->finishedCondition.notify_all();
+    }
+
+    /* Jobs still queued at shutdown finish without a program so nobody waits on them forever */
+    std::lock_guard queueLock(m_QueueMutex);
+    for (auto &job: m_Queue) {
+        {
+            std::lock_guard lock(job->mutex);
+            job->finished = true;
+        }
+        job->finishedCondition.notify_all();
+    }
+    m_Queue.clear();
+
+    m_SetWorkerContextCurrent(false);
+}
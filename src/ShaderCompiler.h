@@ -0,0 +1,73 @@
+#ifndef OPENGL_SHADERCOMPILER_H
+#define OPENGL_SHADERCOMPILER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ProgramBinaryCache.h"
+#include "Shader.h"
+
+/* One asynchronous program build, shared between the owning Shader and the compiler */
+struct ShaderCompileJob {
+    ShaderProgramSource source;
+    std::string name;
+    const ProgramBinaryCache *binaryCache = nullptr;
+    ProgramBinaryKey binaryKey{};
+
+    /* KHR_parallel_shader_compile: objects the driver is building in the background */
+    PendingProgram pending{};
+
+    /* Worker thread: program and fence handed over once the build is done */
+    std::mutex mutex;
+    std::condition_variable finishedCondition;
+    bool finished = false;
+    bool cancelled = false;
+    void *fence = nullptr;
+
+    unsigned int program = 0;
+};
+
+/* Builds programs off the main thread. With KHR_parallel_shader_compile the driver compiles in the background
+ * and completion is polled with GL_COMPLETION_STATUS_KHR. Otherwise, given a way to make a context that shares
+ * objects with the main one current on another thread, compile and link run on a worker thread and a fence
+ * tells the main thread when the program is usable. With neither, programs are built on submit */
+class ShaderCompiler {
+private:
+    bool m_ParallelCompile;
+    std::function<void(bool current)> m_SetWorkerContextCurrent;
+
+    std::thread m_Worker;
+    std::mutex m_QueueMutex;
+    std::condition_variable m_QueueCondition;
+    std::deque<std::shared_ptr<ShaderCompileJob>> m_Queue;
+    bool m_Stopping = false;
+
+public:
+    explicit ShaderCompiler(std::function<void(bool current)> setWorkerContextCurrent = nullptr);
+    ~ShaderCompiler();
+
+    ShaderCompiler(const ShaderCompiler &) = delete;
+    ShaderCompiler &operator=(const ShaderCompiler &) = delete;
+
+    std::shared_ptr<ShaderCompileJob> submit(ShaderProgramSource source, const std::string &name,
+                                             const ProgramBinaryCache *binaryCache,
+                                             const ProgramBinaryKey &binaryKey);
+
+    /* Main thread only. poll() never blocks; after it returns true (or wait() returns) job.program is usable */
+    static bool poll(ShaderCompileJob &job);
+    static void wait(ShaderCompileJob &job);
+    /* Releases whatever the job owns, now or when the worker gets to it */
+    static void cancel(ShaderCompileJob &job);
+
+    inline bool usesParallelCompile() const { return m_ParallelCompile; }
+    inline bool usesWorkerThread() const { return m_Worker.joinable(); }
+
+private:
+    void workerLoop();
+};
+
+#endif //OPENGL_SHADERCOMPILER_H
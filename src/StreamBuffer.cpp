@@ -0,0 +1,125 @@
+#include <iostream>
+#include "StreamBuffer.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "Renderer.h"
+
+/* Creation and mapping go through GL_COPY_WRITE_BUFFER: binding GL_ELEMENT_ARRAY_BUFFER here would
+ * change whichever VAO happens to be bound */
+StreamBuffer::StreamBuffer(unsigned int target, unsigned int size) :
+    m_RendererID(0), m_Target(target), m_Size(size), m_Persistent(GLAD_GL_ARB_buffer_storage),
+    m_MappedData(nullptr), m_RangeMapped(false), m_Head(0), m_Tail(0) {
+    GLCall(glGenBuffers(1, &m_RendererID));
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+
+    if (m_Persistent) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_COPY_WRITE_BUFFER, m_Size, nullptr, flags));
+        GLCall(m_MappedData = (unsigned char *) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_Size, flags));
+        if (!m_MappedData) {
+            /* Immutable storage can't be respecified, so the range-mapped path gets a new buffer */
+            std::cout << "Warning: couldn't map stream buffer persistently, mapping per allocation" << std::endl;
+            GLCall(glDeleteBuffers(1, &m_RendererID));
+            GLState::get().onDeleteBuffer(m_RendererID);
+            GLCall(glGenBuffers(1, &m_RendererID));
+            GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+            m_Persistent = false;
+        }
+    }
+    if (!m_Persistent) {
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (const FrameFence &fence: m_Fences) {
+        GLCall(glDeleteSync((GLsync) fence.sync));
+    }
+    if (m_Persistent || m_RangeMapped) {
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+        GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    }
+    GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::get().onDeleteBuffer(m_RendererID);
+}
+
+StreamAllocation StreamBuffer::allocate(unsigned int size, unsigned int alignment) {
+    ASSERT(alignment > 0);
+    if (size == 0 || size > m_Size)
+        return {nullptr, 0};
+
+    uint64_t physical = m_Head % m_Size;
+    uint64_t aligned = (physical + alignment - 1) / alignment * alignment;
+    /* Allocations never straddle the end of the buffer; skip the rest of it and restart at 0 instead */
+    bool wraps = aligned + size > m_Size;
+    uint64_t start = m_Head + (wraps ? m_Size - physical : aligned - physical);
+    uint64_t end = start + size;
+    auto offset = (unsigned int) (start % m_Size);
+
+    if (m_Persistent) {
+        /* Reclaim whole frames, oldest first, until the range doesn't overlap anything still in flight */
+        while (end - m_Tail > m_Size) {
+            if (m_Fences.empty())
+                return {nullptr, 0}; /* The current frame alone has filled the buffer */
+
+            FrameFence &oldest = m_Fences.front();
+            GLCall(glClientWaitSync((GLsync) oldest.sync, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+            GLCall(glDeleteSync((GLsync) oldest.sync));
+            m_Tail = oldest.end;
+            m_Fences.pop_front();
+        }
+        m_Head = end;
+        return {m_MappedData + offset, offset};
+    }
+
+    commit();
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    if (wraps) {
+        /* Orphan: the driver hands out fresh storage and frees the old one once pending draws are done */
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, m_Size, nullptr, GL_STREAM_DRAW));
+    }
+    /* Nothing the GPU may be reading lies in this range, so there is no need to synchronise */
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    GLCall(void *data = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, access));
+    m_RangeMapped = data != nullptr;
+    m_Head = end;
+    m_Tail = m_Head;
+    return {data, offset};
+}
+
+void StreamBuffer::commit() {
+    if (!m_RangeMapped)
+        return;
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(glUnmapBuffer(GL_COPY_WRITE_BUFFER));
+    m_RangeMapped = false;
+}
+
+void StreamBuffer::endFrame() {
+    commit();
+    if (!m_Persistent)
+        return;
+
+    /* Drop fences that have already signalled, so allocate() rarely has to wait */
+    while (!m_Fences.empty()) {
+        GLCall(GLenum status = glClientWaitSync((GLsync) m_Fences.front().sync, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED)
+            break;
+        GLCall(glDeleteSync((GLsync) m_Fences.front().sync));
+        m_Tail = m_Fences.front().end;
+        m_Fences.pop_front();
+    }
+
+    if (m_Head == (m_Fences.empty() ? m_Tail : m_Fences.back().end))
+        return; /* Nothing written this frame */
+    GLCall(GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    m_Fences.push_back({sync, m_Head});
+}
+
+void StreamBuffer::bind() const {
+    GLState::get().bindBuffer(m_Target, m_RendererID);
+}
+
+void StreamBuffer::unBind() const {
+    GLState::get().bindBuffer(m_Target, 0);
+}
@@ -0,0 +1,63 @@
+#ifndef OPENGL_STREAMBUFFER_H
+#define OPENGL_STREAMBUFFER_H
+
+#include <cstdint>
+#include <deque>
+
+struct StreamAllocation {
+    void *data;          /* Write-only, nullptr if the request can't fit */
+    unsigned int offset; /* Byte offset of data in the buffer, for attribute pointers or base vertices */
+};
+
+/* Ring buffer for data rewritten every frame (UI, particles, debug lines).
+ * With ARB_buffer_storage the whole buffer is mapped once, persistently and coherently, and callers write
+ * straight into it; a fence placed by endFrame() guards each frame's range until the GPU is done with it.
+ * On plain GL 3.3, or if the persistent map fails, each allocation maps its range unsynchronised and the store is orphaned on wrap-around,
+ * leaving the driver to keep the old contents alive for draws still in flight */
+class StreamBuffer {
+private:
+    struct FrameFence {
+        void *sync;
+        uint64_t end;
+    };
+
+    unsigned int m_RendererID;
+    unsigned int m_Target;
+    unsigned int m_Size;
+    bool m_Persistent;
+    unsigned char *m_MappedData;
+    bool m_RangeMapped;
+
+    /* Positions grow monotonically and the physical offset is position % m_Size.
+     * [m_Tail, m_Head) may still be read by the GPU; m_Fences holds the end of each frame in that range */
+    uint64_t m_Head;
+    uint64_t m_Tail;
+    std::deque<FrameFence> m_Fences;
+
+public:
+    StreamBuffer(unsigned int target, unsigned int size);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    /* [alignment] need not be a power of two: pass the vertex stride to get offsets usable as base vertices.
+     * In fallback mode only the latest allocation is mapped, so fill it before allocating again.
+     * Returns nullptr data, which callers must check, when [size] is 0 or larger than the buffer, when with a
+     * persistent mapping this frame's allocations already fill the buffer (so nothing is fenced that could be
+     * waited on), or when the fallback mapping fails */
+    StreamAllocation allocate(unsigned int size, unsigned int alignment = 4);
+    /* Must be called after writing and before drawing from the data; free with a persistent mapping */
+    void commit();
+    /* Fences everything allocated this frame, call once the frame's draws are submitted */
+    void endFrame();
+
+    void bind() const;
+    void unBind() const;
+
+    inline unsigned int getRendererID() const { return m_RendererID; }
+    inline unsigned int getSize() const { return m_Size; }
+    inline bool isPersistent() const { return m_Persistent; }
+};
+
+#endif //OPENGL_STREAMBUFFER_H
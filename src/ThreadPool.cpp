@@ -0,0 +1,72 @@
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    for (unsigned int i = 1; i < threadCount; i++)
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_WorkCondition.notify_all();
+    for (std::thread &worker: m_Workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &task) {
+    grain = std::max<size_t>(grain, 1);
+    if (m_Workers.empty() || count <= grain) {
+        if (count > 0)
+            task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Task = &task;
+        m_Count = count;
+        m_Grain = grain;
+        m_Next.store(0, std::memory_order_relaxed);
+        m_Running = (unsigned int) m_Workers.size();
+        m_Generation++;
+    }
+    m_WorkCondition.notify_all();
+
+    runChunks();
+
+    /* Workers that wake up after the chunks ran out still check in, so m_Task stays valid until they have */
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_DoneCondition.wait(lock, [this] { return m_Running == 0; });
+    m_Task = nullptr;
+}
+
+void ThreadPool::runChunks() {
+    for (;;) {
+        size_t begin = m_Next.fetch_add(m_Grain, std::memory_order_relaxed);
+        if (begin >= m_Count)
+            return;
+        (*m_Task)(begin, std::min(begin + m_Grain, m_Count));
+    }
+}
+
+void ThreadPool::workerLoop() {
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCondition.wait(lock, [&] { return m_Stopping || m_Generation != seenGeneration; });
+            if (m_Stopping)
+                return;
+            seenGeneration = m_Generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (--m_Running == 0)
+            m_DoneCondition.notify_one();
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef OPENGL_THREADPOOL_H
+#define OPENGL_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed set of worker threads for data-parallel loops within a frame. The calling thread takes chunks too,
+ * so a pool of one thread has no workers and runs everything inline */
+class ThreadPool {
+private:
+    std::vector<std::thread> m_Workers;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkCondition;
+    std::condition_variable m_DoneCondition;
+    uint64_t m_Generation = 0; /* Bumped for each parallelFor so workers can tell a new loop from a spurious wakeup */
+    unsigned int m_Running = 0;
+    bool m_Stopping = false;
+
+    /* The loop in progress; chunks are claimed by advancing m_Next */
+    const std::function<void(size_t begin, size_t end)> *m_Task = nullptr;
+    size_t m_Count = 0;
+    size_t m_Grain = 1;
+    std::atomic<size_t> m_Next{0};
+
+public:
+    /* [threadCount] includes the caller, defaults to one per hardware thread */
+    explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /* Calls task(begin, end) over [0, count) in chunks of [grain] (the last one may be shorter) and returns once
+     * all are done. Chunks start at multiples of [grain]. Not reentrant: one loop at a time, from one thread */
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> &task);
+
+    inline unsigned int getThreadCount() const { return (unsigned int) m_Workers.size() + 1; }
+
+private:
+    void runChunks();
+    void workerLoop();
+};
+
+#endif //OPENGL_THREADPOOL_H
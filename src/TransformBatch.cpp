@@ -0,0 +1,132 @@
+#include "TransformBatch.h"
+#include "Float4.h"
+#include "ThreadPool.h"
+
+/* Objects per ThreadPool chunk: enough work to outweigh claiming it, a multiple of 4 so only the last chunk
+ * has a partial group */
+static constexpr size_t TRANSFORM_GRAIN = 1024;
+
+void TransformBatch::resize(size_t count) {
+    positionX.resize(count, 0.f);
+    positionY.resize(count, 0.f);
+    positionZ.resize(count, 0.f);
+    rotationX.resize(count, 0.f);
+    rotationY.resize(count, 0.f);
+    rotationZ.resize(count, 0.f);
+    rotationW.resize(count, 1.f);
+    scaleX.resize(count, 1.f);
+    scaleY.resize(count, 1.f);
+    scaleZ.resize(count, 1.f);
+}
+
+void TransformBatch::set(size_t index, vec3 const position, quat const rotation, vec3 const scale) {
+    positionX[index] = position[0];
+    positionY[index] = position[1];
+    positionZ[index] = position[2];
+    rotationX[index] = rotation[0];
+    rotationY[index] = rotation[1];
+    rotationZ[index] = rotation[2];
+    rotationW[index] = rotation[3];
+    scaleX[index] = scale[0];
+    scaleY[index] = scale[1];
+    scaleZ[index] = scale[2];
+}
+
+/* One component of four consecutive objects, in TransformBatch's member order */
+enum TransformComponent {
+    POSITION_X, POSITION_Y, POSITION_Z, ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W, SCALE_X, SCALE_Y, SCALE_Z,
+    COMPONENT_COUNT
+};
+
+/* Matrices for four objects at once, one object per lane: entries are computed as columns of lanes and
+ * transposed into each object's columns just before the store. [lanes] < 4 only for the last group */
+static void transformGroup(const float4 in[COMPONENT_COUNT], const float4 viewProjection[4][4],
+                           mat4x4 *models, mat4x4 *mvps, size_t lanes) {
+    float4 x = in[ROTATION_X], y = in[ROTATION_Y], z = in[ROTATION_Z], w = in[ROTATION_W];
+    float4 one = broadcast4(1.f), two = broadcast4(2.f);
+    float4 xx = mul4(x, x), yy = mul4(y, y), zz = mul4(z, z);
+    float4 xy = mul4(x, y), xz = mul4(x, z), yz = mul4(y, z);
+    float4 wx = mul4(w, x), wy = mul4(w, y), wz = mul4(w, z);
+
+    /* model[column][row] for rows 0-2; row 3 is (0, 0, 0, 1) */
+    float4 model[4][3] = {
+            {mul4(in[SCALE_X], sub4(one, mul4(two, add4(yy, zz)))),
+             mul4(in[SCALE_X], mul4(two, add4(xy, wz))),
+             mul4(in[SCALE_X], mul4(two, sub4(xz, wy)))},
+            {mul4(in[SCALE_Y], mul4(two, sub4(xy, wz))),
+             mul4(in[SCALE_Y], sub4(one, mul4(two, add4(xx, zz)))),
+             mul4(in[SCALE_Y], mul4(two, add4(yz, wx)))},
+            {mul4(in[SCALE_Z], mul4(two, add4(xz, wy))),
+             mul4(in[SCALE_Z], mul4(two, sub4(yz, wx))),
+             mul4(in[SCALE_Z], sub4(one, mul4(two, add4(xx, yy))))},
+            {in[POSITION_X], in[POSITION_Y], in[POSITION_Z]},
+    };
+
+    for (int column = 0; column < 4; column++) {
+        if (models) {
+            float4 r0 = model[column][0], r1 = model[column][1], r2 = model[column][2];
+            float4 r3 = column == 3 ? one : broadcast4(0.f);
+            transpose4(r0, r1, r2, r3);
+            const float4 objects[4] = {r0, r1, r2, r3};
+            for (size_t lane = 0; lane < lanes; lane++)
+                store4(models[lane][column], objects[lane]);
+        }
+        if (mvps) {
+            float4 rows[4];
+            for (int row = 0; row < 4; row++) {
+                float4 value = mul4(viewProjection[0][row], model[column][0]);
+                value = madd4(viewProjection[1][row], model[column][1], value);
+                value = madd4(viewProjection[2][row], model[column][2], value);
+                rows[row] = column == 3 ? add4(value, viewProjection[3][row]) : value;
+            }
+            transpose4(rows[0], rows[1], rows[2], rows[3]);
+            for (size_t lane = 0; lane < lanes; lane++)
+                store4(mvps[lane][column], rows[lane]);
+        }
+    }
+}
+
+static void transformRange(const TransformBatch &batch, const float4 viewProjection[4][4],
+                           mat4x4 *models, mat4x4 *mvps, size_t begin, size_t end) {
+    const float *components[COMPONENT_COUNT] = {
+            batch.positionX.data(), batch.positionY.data(), batch.positionZ.data(),
+            batch.rotationX.data(), batch.rotationY.data(), batch.rotationZ.data(), batch.rotationW.data(),
+            batch.scaleX.data(), batch.scaleY.data(), batch.scaleZ.data(),
+    };
+
+    float4 in[COMPONENT_COUNT];
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        for (int component = 0; component < COMPONENT_COUNT; component++)
+            in[component] = load4(components[component] + i);
+        transformGroup(in, viewProjection, models ? models + i : nullptr, mvps ? mvps + i : nullptr, 4);
+    }
+
+    if (i < end) {
+        /* Pad the last group with zeros; only the real lanes are stored */
+        for (int component = 0; component < COMPONENT_COUNT; component++) {
+            float padded[4] = {0.f, 0.f, 0.f, 0.f};
+            for (size_t lane = 0; lane < end - i; lane++)
+                padded[lane] = components[component][i + lane];
+            in[component] = load4(padded);
+        }
+        transformGroup(in, viewProjection, models ? models + i : nullptr, mvps ? mvps + i : nullptr, end - i);
+    }
+}
+
+void computeTransforms(const TransformBatch &batch, mat4x4 const viewProjection, mat4x4 *models, mat4x4 *mvps,
+                       ThreadPool *pool) {
+    float4 splatViewProjection[4][4];
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++)
+            splatViewProjection[column][row] = broadcast4(viewProjection[column][row]);
+    }
+
+    auto task = [&](size_t begin, size_t end) {
+        transformRange(batch, splatViewProjection, models, mvps, begin, end);
+    };
+    if (pool)
+        pool->parallelFor(batch.size(), TRANSFORM_GRAIN, task);
+    else
+        task(0, batch.size());
+}
@@ -0,0 +1,30 @@
+#ifndef OPENGL_TRANSFORMBATCH_H
+#define OPENGL_TRANSFORMBATCH_H
+
+#include <cstddef>
+#include <vector>
+#include "linmath.h"
+
+class ThreadPool;
+
+/* Position, rotation and scale of many objects, one array per component so the transform kernel can load
+ * four objects' worth of a component at once. Rotations are unit quaternions stored (x, y, z, w) */
+struct TransformBatch {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    /* New objects get identity transforms */
+    void resize(size_t count);
+    inline size_t size() const { return positionX.size(); }
+
+    void set(size_t index, vec3 const position, quat const rotation, vec3 const scale);
+};
+
+/* model = translate * rotate * scale and mvp = viewProjection * model for every object in [batch]; either output
+ * may be nullptr. Outputs are written in order and never read, so they can point into a mapped buffer such as a
+ * StreamBuffer allocation. With a pool the objects are split across its threads */
+void computeTransforms(const TransformBatch &batch, mat4x4 const viewProjection, mat4x4 *models, mat4x4 *mvps,
+                       ThreadPool *pool = nullptr);
+
+#endif //OPENGL_TRANSFORMBATCH_H
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include "TransformHierarchy.h"
+#include "LinmathSIMD.h"
+#include "VertexBuffer.h"
+
+unsigned int TransformHierarchy::add(unsigned int parent, mat4x4 const local) {
+    auto node = (unsigned int) m_Positions.size();
+    auto size = (unsigned int) m_Nodes.size();
+    unsigned int parentPosition = parent == NO_PARENT ? NO_PARENT : m_Positions[parent];
+    /* New nodes go at the end of their parent's subtree, keeping it contiguous */
+    unsigned int position = parent == NO_PARENT ? size : parentPosition + m_SubtreeSizes[parentPosition];
+
+    if (position < size) {
+        for (unsigned int &other: m_Parents) {
+            if (other != NO_PARENT && other >= position)
+                other++;
+        }
+        for (unsigned int &other: m_Positions) {
+            if (other >= position)
+                other++;
+        }
+    }
+
+    Matrix matrix{};
+    mat4x4_dup(matrix.value, local);
+    m_Parents.insert(m_Parents.begin() + position, parentPosition);
+    m_SubtreeSizes.insert(m_SubtreeSizes.begin() + position, 1);
+    m_Nodes.insert(m_Nodes.begin() + position, node);
+    m_Locals.insert(m_Locals.begin() + position, matrix);
+    m_Worlds.insert(m_Worlds.begin() + position, matrix);
+    m_Positions.push_back(position);
+    m_Dirty.push_back(false);
+
+    for (unsigned int ancestor = parentPosition; ancestor != NO_PARENT; ancestor = m_Parents[ancestor])
+        m_SubtreeSizes[ancestor]++;
+
+    /* The world matrix still needs the parent's */
+    setLocal(node, local);
+    return node;
+}
+
+void TransformHierarchy::setLocal(unsigned int node, mat4x4 const local) {
+    mat4x4_dup(m_Locals[m_Positions[node]].value, local);
+    if (!m_Dirty[node]) {
+        m_Dirty[node] = true;
+        m_DirtyNodes.push_back(node);
+    }
+}
+
+unsigned int TransformHierarchy::update() {
+    m_ChangedSlots.clear();
+    if (m_DirtyNodes.empty())
+        return 0;
+
+    /* Visit dirty nodes in depth-first order so a dirty node's whole subtree is redone once, and dirty
+     * descendants inside it are skipped */
+    std::vector<unsigned int> positions(m_DirtyNodes.size());
+    for (size_t i = 0; i < m_DirtyNodes.size(); i++) {
+        positions[i] = m_Positions[m_DirtyNodes[i]];
+        m_Dirty[m_DirtyNodes[i]] = false;
+    }
+    m_DirtyNodes.clear();
+    std::sort(positions.begin(), positions.end());
+
+    unsigned int updatedEnd = 0;
+    for (unsigned int first: positions) {
+        if (first < updatedEnd)
+            continue;
+
+        updatedEnd = first + m_SubtreeSizes[first];
+        for (unsigned int position = first; position < updatedEnd; position++) {
+            unsigned int parent = m_Parents[position];
+            if (parent == NO_PARENT)
+                mat4x4_dup(m_Worlds[position].value, m_Locals[position].value);
+            else
+                simd::mat4x4_mul(m_Worlds[position].value, m_Worlds[parent].value, m_Locals[position].value);
+            m_ChangedSlots.push_back(m_Nodes[position]);
+        }
+    }
+    return (unsigned int) m_ChangedSlots.size();
+}
+
+void TransformHierarchy::uploadChanged(VertexBuffer &buffer, unsigned int offset) {
+    if (m_ChangedSlots.empty())
+        return;
+
+    std::vector<unsigned int> slots = m_ChangedSlots;
+    std::sort(slots.begin(), slots.end());
+
+    m_UploadStaging.resize(slots.size());
+    size_t runStart = 0;
+    for (size_t i = 0; i < slots.size(); i++) {
+        mat4x4_dup(m_UploadStaging[i].value, getWorld(slots[i]));
+        bool runEnds = i + 1 == slots.size() || slots[i + 1] != slots[i] + 1;
+        if (runEnds) {
+            buffer.setSubData(offset + slots[runStart] * (unsigned int) sizeof(mat4x4), &m_UploadStaging[runStart],
+                              (unsigned int) ((i + 1 - runStart) * sizeof(mat4x4)));
+            runStart = i + 1;
+        }
+    }
+}
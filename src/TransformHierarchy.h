@@ -0,0 +1,63 @@
+#ifndef OPENGL_TRANSFORMHIERARCHY_H
+#define OPENGL_TRANSFORMHIERARCHY_H
+
+#include <vector>
+#include "linmath.h"
+
+class VertexBuffer;
+
+/* Parent/child transforms in flat arrays kept in depth-first order, so every node's subtree is the contiguous
+ * range that follows it and parents always come before their children. Editing a local matrix only marks the
+ * node; update() then recomputes the world matrices of the dirty subtrees, one linear pass each, and records
+ * which instance slots changed. A frame where nothing moved costs a single check.
+ * Node ids are handed out densely from 0 and double as instance slots: world matrix i belongs at index i of
+ * the instance buffer */
+class TransformHierarchy {
+private:
+    struct Matrix {
+        mat4x4 value;
+    };
+
+    /* Indexed by depth-first position; positions move when a node is inserted before them */
+    std::vector<unsigned int> m_Parents;      /* Position of the parent, NO_PARENT for roots */
+    std::vector<unsigned int> m_SubtreeSizes; /* Nodes in the subtree, the node itself included */
+    std::vector<unsigned int> m_Nodes;        /* Id of the node at each position */
+    std::vector<Matrix> m_Locals;
+    std::vector<Matrix> m_Worlds;
+
+    /* Indexed by node id */
+    std::vector<unsigned int> m_Positions;
+    std::vector<bool> m_Dirty;
+
+    std::vector<unsigned int> m_DirtyNodes;
+    std::vector<unsigned int> m_ChangedSlots;
+    std::vector<Matrix> m_UploadStaging;
+
+public:
+    static constexpr unsigned int NO_PARENT = ~0u;
+
+    /* Returns the new node's id. Appending is O(depth) when nodes are added depth first (each node after its
+     * parent's earlier descendants); inserting anywhere else shifts the nodes after it */
+    unsigned int add(unsigned int parent, mat4x4 const local);
+
+    void setLocal(unsigned int node, mat4x4 const local);
+    inline const mat4x4 &getLocal(unsigned int node) const { return m_Locals[m_Positions[node]].value; }
+    /* As of the last update() */
+    inline const mat4x4 &getWorld(unsigned int node) const { return m_Worlds[m_Positions[node]].value; }
+    inline unsigned int getParent(unsigned int node) const {
+        unsigned int parent = m_Parents[m_Positions[node]];
+        return parent == NO_PARENT ? NO_PARENT : m_Nodes[parent];
+    }
+
+    /* Brings world matrices up to date and returns how many were recomputed */
+    unsigned int update();
+    /* Slots whose world matrix changed in the last update(), in depth-first order */
+    inline const std::vector<unsigned int> &getChangedSlots() const { return m_ChangedSlots; }
+    /* Writes the changed world matrices to [buffer] at [offset] + slot * sizeof(mat4x4), one setSubData per run
+     * of consecutive slots */
+    void uploadChanged(VertexBuffer &buffer, unsigned int offset = 0);
+
+    inline unsigned int getNodeCount() const { return (unsigned int) m_Nodes.size(); }
+};
+
+#endif //OPENGL_TRANSFORMHIERARCHY_H
@@ -1,6 +1,9 @@
 #include "VertexBufferLayout.h"
 #include "VertexArray.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "StreamBuffer.h"
+#include "GLExtensions.h"
 
 VertexArray::VertexArray() {
     GLCall(glGenVertexArrays(1, &m_RendererID));
@@ -8,16 +11,42 @@ VertexArray::VertexArray() {
 
 VertexArray::~VertexArray() {
     GLCall(glDeleteVertexArrays(1, &m_RendererID));
+    GLState::get().onDeleteVertexArray(m_RendererID);
 }
 
-void VertexArray::addBuffer(const VertexBuffer &vb, const VertexBufferLayout &layout) {
+void VertexArray::addBuffer(const VertexBuffer &vb, const VertexBufferLayout &layout, unsigned int offset) {
     bind();
     vb.bind();
+    setAttributes(layout, offset);
+}
+
+void VertexArray::addBuffer(const StreamBuffer &sb, const VertexBufferLayout &layout, unsigned int offset) {
+    bind();
+    sb.bind();
+    setAttributes(layout, offset);
+}
+
+void VertexArray::setFormat(const VertexBufferLayout &layout) {
+    bind();
     const auto &elements = layout.GetElement();
+    for (const auto &element: elements) {
+        GLCall(glEnableVertexAttribArray(element.location));
+        GLCall(glVertexAttribFormat(element.location, element.count, element.type, element.normalised,
+                                    element.offset));
+        GLCall(glVertexAttribBinding(element.location, 0));
+    }
+    GLCall(glVertexBindingDivisor(0, elements.empty() ? 0 : elements[0].divisor));
+}
+
+void VertexArray::bindVertexBuffer(const VertexBuffer &vb, unsigned int stride, unsigned int offset) {
+    bind();
+    GLCall(glBindVertexBuffer(0, vb.getRendererID(), offset, stride));
+}
 
-    unsigned int offset = 0;
+void VertexArray::setAttributes(const VertexBufferLayout &layout, unsigned int offset) {
+    const auto &elements = layout.GetElement();
 
-    for (auto element: elements) {
+    for (const auto &element: elements) {
         GLCall(glEnableVertexAttribArray(element.location));
         GLCall(glVertexAttribPointer(
                 element.location,
@@ -25,16 +54,16 @@ void VertexArray::addBuffer(const VertexBuffer &vb, const VertexBufferLayout &la
                 element.type,
                 element.normalised,
                 layout.getStride(),
-                (const void *) offset
+                (const void *) (uintptr_t) (offset + element.offset)
         ));
-        offset += element.count * VertexBufferElement::getSizeOfType(element.type);
+        GLCall(glVertexAttribDivisor(element.location, element.divisor));
     }
 }
 
 void VertexArray::bind() const {
-    GLCall(glBindVertexArray(m_RendererID));
+    GLState::get().bindVertexArray(m_RendererID);
 }
 
 void VertexArray::unBind() const {
-    GLCall(glBindVertexArray(0));
+    GLState::get().bindVertexArray(0);
 }
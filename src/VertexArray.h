@@ -4,6 +4,7 @@
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
+class StreamBuffer;
 
 class VertexArray {
 private:
@@ -12,11 +13,26 @@ public:
     VertexArray();
     ~VertexArray();
 
-    void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+    /* Attributes start [offset] bytes into the buffer */
+    void addBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, unsigned int offset = 0);
+    /* Either address per-frame vertices with the allocation offset / stride as first vertex, or call again each
+     * frame with the allocation offset (the only way to move per-instance data without base instance) */
+    void addBuffer(const StreamBuffer& sb, const VertexBufferLayout& layout, unsigned int offset = 0);
+
+    /* ARB_vertex_attrib_binding: records the layout's formats against binding point 0 without a buffer, which
+     * bindVertexBuffer() then swaps cheaply. All elements must share one divisor */
+    void setFormat(const VertexBufferLayout& layout);
+    void bindVertexBuffer(const VertexBuffer& vb, unsigned int stride, unsigned int offset = 0);
 
     void bind() const;
 
     void unBind() const;
+
+    inline unsigned int getRendererID() const { return m_RendererID; }
+
+private:
+    /* Points the layout's attributes at the buffer currently bound to GL_ARRAY_BUFFER */
+    void setAttributes(const VertexBufferLayout& layout, unsigned int offset);
 };
 
 #endif //OPENGL_VERTEXARRAY_H
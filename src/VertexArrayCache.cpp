@@ -0,0 +1,103 @@
+#include "VertexArrayCache.h"
+#include "IndexBuffer.h"
+#include "GLExtensions.h"
+
+static uint64_t mix(uint64_t hash, uint64_t value) {
+    /* FNV-1a step over a whole word; layouts are only a handful of elements */
+    return (hash ^ value) * 0x100000001B3ull;
+}
+
+static uint64_t hashLayout(const VertexBufferLayout &layout) {
+    uint64_t hash = mix(0xCBF29CE484222325ull, layout.getStride());
+    for (const VertexBufferElement &element: layout.GetElement()) {
+        hash = mix(hash, ((uint64_t) element.type << 32) | element.count);
+        hash = mix(hash, ((uint64_t) element.location << 32) | element.offset);
+        hash = mix(hash, ((uint64_t) element.divisor << 8) | element.normalised);
+    }
+    return hash;
+}
+
+static bool sameLayout(const std::vector<VertexBufferElement> &elements, unsigned int stride,
+                       const VertexBufferLayout &layout) {
+    const auto &other = layout.GetElement();
+    if (stride != layout.getStride() || elements.size() != other.size())
+        return false;
+    for (size_t i = 0; i < elements.size(); i++) {
+        const VertexBufferElement &a = elements[i], &b = other[i];
+        if (a.type != b.type || a.count != b.count || a.normalised != b.normalised || a.location != b.location ||
+            a.divisor != b.divisor || a.offset != b.offset)
+            return false;
+    }
+    return true;
+}
+
+/* One binding point carries a single divisor, so mixed layouts get a VAO per buffer set instead */
+static bool singleDivisor(const VertexBufferLayout &layout) {
+    const auto &elements = layout.GetElement();
+    for (const VertexBufferElement &element: elements) {
+        if (element.divisor != elements[0].divisor)
+            return false;
+    }
+    return true;
+}
+
+/* Caches created on this thread, whose VAOs belong to the context current on it */
+static std::vector<VertexArrayCache *> &liveCaches() {
+    thread_local std::vector<VertexArrayCache *> caches;
+    return caches;
+}
+
+VertexArrayCache::VertexArrayCache() : m_SeparateFormat(GLAD_GL_ARB_vertex_attrib_binding) {
+    liveCaches().push_back(this);
+}
+
+VertexArrayCache::~VertexArrayCache() {
+    std::erase(liveCaches(), this);
+}
+
+const VertexArray &VertexArrayCache::bind(const VertexBuffer &vb, const VertexBufferLayout &layout,
+                                          const IndexBuffer &ib) {
+    bool separateFormat = m_SeparateFormat && singleDivisor(layout);
+    uint64_t key = hashLayout(layout);
+    if (!separateFormat)
+        key = mix(mix(key, vb.getRendererID()), ib.getRendererID());
+
+    Entry &entry = m_Entries[key];
+    if (!entry.vertexArray || !sameLayout(entry.elements, entry.stride, layout)) {
+        /* New, or a hash collision: either way the slot is rebuilt for this layout */
+        entry.vertexArray = std::make_unique<VertexArray>();
+        entry.elements = layout.GetElement();
+        entry.stride = layout.getStride();
+        entry.vertexBuffer = 0;
+        entry.indexBuffer = 0;
+        if (separateFormat)
+            entry.vertexArray->setFormat(layout);
+    }
+
+    const VertexArray &vertexArray = *entry.vertexArray;
+    vertexArray.bind();
+    if (entry.vertexBuffer != vb.getRendererID()) {
+        if (separateFormat)
+            entry.vertexArray->bindVertexBuffer(vb, entry.stride);
+        else
+            entry.vertexArray->addBuffer(vb, layout);
+        entry.vertexBuffer = vb.getRendererID();
+    }
+    if (entry.indexBuffer != ib.getRendererID()) {
+        ib.bind();
+        entry.indexBuffer = ib.getRendererID();
+    }
+    return vertexArray;
+}
+
+void VertexArrayCache::onDeleteBuffer(unsigned int bufferID) {
+    for (VertexArrayCache *cache: liveCaches())
+        cache->release(bufferID);
+}
+
+void VertexArrayCache::release(unsigned int bufferID) {
+    /* Deleting the VAO drops its references; a shared per-layout VAO is simply rebuilt on next use */
+    std::erase_if(m_Entries, [bufferID](const auto &item) {
+        return item.second.vertexBuffer == bufferID || item.second.indexBuffer == bufferID;
+    });
+}
@@ -0,0 +1,51 @@
+#ifndef OPENGL_VERTEXARRAYCACHE_H
+#define OPENGL_VERTEXARRAYCACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
+
+class IndexBuffer;
+
+/* Hands out VAOs for (layout, vertex buffer, index buffer) combinations instead of one VertexArray per mesh.
+ * With ARB_vertex_attrib_binding there is a single VAO per layout whose formats are set once, and binding
+ * another mesh only swaps its vertex and index buffers. Otherwise each combination gets its own VAO,
+ * built on first use and reused afterwards */
+class VertexArrayCache {
+private:
+    struct Entry {
+        std::unique_ptr<VertexArray> vertexArray;
+        std::vector<VertexBufferElement> elements; /* To tell layouts apart when their hashes collide */
+        unsigned int stride;
+        unsigned int vertexBuffer; /* Currently attached */
+        unsigned int indexBuffer;
+    };
+
+    std::unordered_map<uint64_t, Entry> m_Entries;
+    bool m_SeparateFormat;
+
+public:
+    VertexArrayCache();
+    ~VertexArrayCache();
+
+    VertexArrayCache(const VertexArrayCache &) = delete;
+    VertexArrayCache &operator=(const VertexArrayCache &) = delete;
+
+    /* Binds a VAO reading [layout] from [vb] with [ib] as its element buffer and returns it */
+    const VertexArray &bind(const VertexBuffer &vb, const VertexBufferLayout &layout, const IndexBuffer &ib);
+
+    /* Drops every VAO referencing [bufferID]: GL keeps a deleted buffer alive while a VAO still references it,
+     * and a new buffer may be given the same name */
+    void release(unsigned int bufferID);
+
+    /* Releases [bufferID] from every cache on this thread; ~VertexBuffer and ~IndexBuffer call it, the same way
+     * they tell GLState */
+    static void onDeleteBuffer(unsigned int bufferID);
+
+    inline size_t getVertexArrayCount() const { return m_Entries.size(); }
+};
+
+#endif //OPENGL_VERTEXARRAYCACHE_H
@@ -1,22 +1,31 @@
 #include "VertexBufferLayout.h"
 #include "VertexBuffer.h"
 #include "Renderer.h"
+#include "GLState.h"
+#include "VertexArrayCache.h"
 
 VertexBuffer::VertexBuffer(const void *data, unsigned int size) {
     GLCall(glGenBuffers(1, &m_RendererID)) ; /* Create for me a buffer */
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID)); /* Set buffer type */
+    GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_RendererID); /* Set buffer type */
     /* Creates and initializes a buffer object's data store */
     GLCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 VertexBuffer::~VertexBuffer() {
+    VertexArrayCache::onDeleteBuffer(m_RendererID);
     GLCall(glDeleteBuffers(1, &m_RendererID));
+    GLState::get().onDeleteBuffer(m_RendererID);
+}
+
+void VertexBuffer::setSubData(unsigned int offset, const void *data, unsigned int size) {
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, m_RendererID));
+    GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data));
 }
 
 void VertexBuffer::bind() const {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GLState::get().bindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 }
 
 void VertexBuffer::unBind() const {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0 ));
+    GLState::get().bindBuffer(GL_ARRAY_BUFFER, 0);
 }
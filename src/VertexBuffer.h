@@ -5,11 +5,16 @@ class VertexBuffer {
 private:
     unsigned int m_RendererID;
 public:
+     /* [data] may be nullptr to only reserve storage, filled later with setSubData */
      VertexBuffer(const void* data, unsigned int size);
      ~VertexBuffer();
 
+     void setSubData(unsigned int offset, const void* data, unsigned int size);
+
      void bind() const;
      void unBind() const;
+
+     inline unsigned int getRendererID() const { return m_RendererID; }
 };
 
 #endif //OPENGL_VERTEXBUFFER_H
@@ -1,27 +1,44 @@
 #ifndef OPENGL_VERTEXBUFFERLAYOUT_H
 #define OPENGL_VERTEXBUFFERLAYOUT_H
 
+#include <utility>
 #include <vector>
 #include "Renderer.h"
+#include "VertexPacking.h"
 
 struct VertexBufferElement {
     unsigned int type;
     unsigned int count;
     unsigned char normalised;
     unsigned int location;
+    unsigned int divisor; /* 0 advances per vertex, n advances once every n instances */
+    unsigned int offset;  /* Bytes from the start of the vertex */
 
-    static unsigned int getSizeOfType(unsigned int type) {
+    static constexpr unsigned int getSizeOfType(unsigned int type) {
         switch (type) {
             case GL_FLOAT:
                 return sizeof(float);
             case GL_UNSIGNED_INT:
-                return sizeof(float);
+                return sizeof(unsigned int);
             case GL_UNSIGNED_BYTE:
-                return sizeof(char);
+                return sizeof(unsigned char);
+            case GL_HALF_FLOAT:
+                return sizeof(half);
+            case GL_SHORT:
+                return sizeof(short);
+            case GL_BYTE:
+                return sizeof(signed char);
+            case GL_INT_2_10_10_10_REV: /* All four components together */
+                return sizeof(int2_10_10_10);
         }
         ASSERT(false);
         return 0;
     }
+
+    /* Bytes [count] components of [type] take in a vertex */
+    static constexpr unsigned int getSize(unsigned int type, unsigned int count) {
+        return type == GL_INT_2_10_10_10_REV ? getSizeOfType(type) : getSizeOfType(type) * count;
+    }
 };
 
 class VertexBufferLayout {
@@ -31,28 +48,70 @@ private:
 public:
     VertexBufferLayout() : m_Stride(0) {};
 
+    /* A layout stored elsewhere, e.g. in a mesh file; offsets are taken as given */
+    VertexBufferLayout(std::vector<VertexBufferElement> elements, unsigned int stride) :
+        m_Elements(std::move(elements)), m_Stride(stride) {};
+
+    /* A non-zero [divisor] makes the attribute per-instance */
     template<typename T>
-    void Push(unsigned int count, unsigned int location);
+    void Push(unsigned int count, unsigned int location, unsigned int divisor = 0);
 
     template<>
-    void Push<float>(unsigned int count, unsigned int location) {
-        m_Elements.push_back({GL_FLOAT, count, GL_FALSE, location});
+    void Push<float>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_FLOAT, count, GL_FALSE, location, divisor, m_Stride});
         m_Stride += VertexBufferElement::getSizeOfType(GL_FLOAT) * count;
     }
 
     template<>
-    void Push<unsigned int>(unsigned int count, unsigned int location) {
-        m_Elements.push_back({GL_UNSIGNED_INT, count, GL_FALSE, location});
+    void Push<unsigned int>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_UNSIGNED_INT, count, GL_FALSE, location, divisor, m_Stride});
         m_Stride += VertexBufferElement::getSizeOfType(GL_UNSIGNED_INT) * count;
     }
 
     template<>
-    void Push<unsigned char>(unsigned int count, unsigned int location) {
-        m_Elements.push_back({GL_UNSIGNED_BYTE, count, GL_TRUE, location});
+    void Push<unsigned char>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_UNSIGNED_BYTE, count, GL_TRUE, location, divisor, m_Stride});
         m_Stride += VertexBufferElement::getSizeOfType(GL_UNSIGNED_BYTE) * count;
     }
 
-    inline const std::vector<VertexBufferElement> GetElement() const { return m_Elements; }
+    template<>
+    void Push<half>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_HALF_FLOAT, count, GL_FALSE, location, divisor, m_Stride});
+        m_Stride += VertexBufferElement::getSizeOfType(GL_HALF_FLOAT) * count;
+    }
+
+    template<>
+    void Push<short>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_SHORT, count, GL_TRUE, location, divisor, m_Stride});
+        m_Stride += VertexBufferElement::getSizeOfType(GL_SHORT) * count;
+    }
+
+    template<>
+    void Push<signed char>(unsigned int count, unsigned int location, unsigned int divisor) {
+        m_Elements.push_back({GL_BYTE, count, GL_TRUE, location, divisor, m_Stride});
+        m_Stride += VertexBufferElement::getSizeOfType(GL_BYTE) * count;
+    }
+
+    /* [count] packed vectors at consecutive locations, each read by the shader as a normalised vec4.
+     * Before GL 4.2 signed normalised values decode as (2c + 1) / (2^b - 1), so -1, 0 and 1 are inexact */
+    template<>
+    void Push<int2_10_10_10>(unsigned int count, unsigned int location, unsigned int divisor) {
+        for (unsigned int vector = 0; vector < count; vector++) {
+            m_Elements.push_back({GL_INT_2_10_10_10_REV, 4, GL_TRUE, location + vector, divisor, m_Stride});
+            m_Stride += VertexBufferElement::getSize(GL_INT_2_10_10_10_REV, 4);
+        }
+    }
+
+    /* [count] matrices, each taking four consecutive locations (one per column) starting at [location] */
+    template<>
+    void Push<mat4x4>(unsigned int count, unsigned int location, unsigned int divisor) {
+        for (unsigned int column = 0; column < 4 * count; column++) {
+            m_Elements.push_back({GL_FLOAT, 4, GL_FALSE, location + column, divisor, m_Stride});
+            m_Stride += VertexBufferElement::getSizeOfType(GL_FLOAT) * 4;
+        }
+    }
+
+    inline const std::vector<VertexBufferElement> &GetElement() const { return m_Elements; }
 
     inline unsigned int getStride() const { return m_Stride; }
 
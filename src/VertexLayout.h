@@ -0,0 +1,47 @@
+#ifndef OPENGL_VERTEXLAYOUT_H
+#define OPENGL_VERTEXLAYOUT_H
+
+#include <array>
+#include "VertexBufferLayout.h"
+
+/* [Count] components of [T], where T is one of the types VertexBufferLayout::Push accepts */
+template<typename T, unsigned int Count>
+struct Attr {
+    using type = T;
+    static constexpr unsigned int count = Count;
+    static constexpr unsigned int size = sizeof(T) * Count;
+};
+
+/* Vertex format known at compile time, e.g. VertexLayout<Attr<float, 2>, Attr<float, 3>>.
+ * Attributes are tightly packed in declaration order, the same rule VertexBufferLayout::Push follows */
+template<typename... Attrs>
+struct VertexLayout {
+    static constexpr unsigned int attributeCount = sizeof...(Attrs);
+    static constexpr unsigned int stride = (Attrs::size + ... + 0u);
+    static constexpr std::array<unsigned int, sizeof...(Attrs)> offsets = [] {
+        std::array<unsigned int, sizeof...(Attrs)> result{};
+        unsigned int offset = 0, attribute = 0;
+        ((result[attribute++] = offset, offset += Attrs::size), ...);
+        return result;
+    }();
+
+    /* Runtime layout for VertexArray::addBuffer; [locations] are given in attribute order */
+    static VertexBufferLayout toRuntime(const std::array<unsigned int, sizeof...(Attrs)> &locations,
+                                        unsigned int divisor = 0) {
+        VertexBufferLayout layout;
+        unsigned int attribute = 0;
+        (layout.Push<typename Attrs::type>(Attrs::count, locations[attribute++], divisor), ...);
+        return layout;
+    }
+};
+
+/* Layout of a vertex struct that declares `using Layout = VertexLayout<...>;` matching its members.
+ * Member offsets can be checked the same way: static_assert(offsetof(V, m) == V::Layout::offsets[i]) */
+template<typename Vertex>
+VertexBufferLayout makeVertexLayout(const std::array<unsigned int, Vertex::Layout::attributeCount> &locations,
+                                    unsigned int divisor = 0) {
+    static_assert(sizeof(Vertex) == Vertex::Layout::stride, "Vertex::Layout doesn't cover every byte of the vertex");
+    return Vertex::Layout::toRuntime(locations, divisor);
+}
+
+#endif //OPENGL_VERTEXLAYOUT_H
@@ -0,0 +1,145 @@
+#include "VertexPacking.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#define OPENGL_PACKING_SSE2
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define OPENGL_PACKING_NEON
+#include <arm_neon.h>
+#endif
+
+/* Round to nearest even, overflow to infinity, NaN stays NaN */
+static uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    auto sign = (uint16_t) ((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+
+    if (bits >= 0x7F800000) /* Infinity or NaN */
+        return sign | 0x7C00 | (bits > 0x7F800000 ? 0x200 : 0);
+    if (bits >= 0x477FF000) /* 65520 and above round up past the largest half */
+        return sign | 0x7C00;
+    if (bits < 0x38800000) { /* Below 2^-14 the result is subnormal: scale so the mantissa is an integer */
+        float magnitude;
+        memcpy(&magnitude, &bits, sizeof(magnitude));
+        return sign | (uint16_t) std::lrintf(magnitude * 16777216.f);
+    }
+
+    /* Rebias the exponent from 127 to 15 and round the 13 dropped mantissa bits to nearest even */
+    bits += 0xC8000FFF + ((bits >> 13) & 1);
+    return sign | (uint16_t) (bits >> 13);
+}
+
+/* Written so that NaN fails both comparisons and ends up at -1, like the SSE max/min below */
+static float clampSnorm(float value) {
+    return value > -1.f ? (value < 1.f ? value : 1.f) : -1.f;
+}
+
+#ifdef OPENGL_PACKING_SSE2
+__attribute__((target("avx,f16c")))
+static size_t packHalfF16C(const float *source, half *destination, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i *) (destination + i), packed);
+    }
+    return i;
+}
+
+static __m128 clampScaleSSE(__m128 value, __m128 scale) {
+    return _mm_mul_ps(_mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f)), scale);
+}
+#endif
+
+void packHalf(const float *source, half *destination, size_t count) {
+    size_t i = 0;
+#if defined(OPENGL_PACKING_SSE2)
+    static const bool hasF16C = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    if (hasF16C)
+        i = packHalfF16C(source, destination, count);
+#elif defined(OPENGL_PACKING_NEON)
+    for (; i + 4 <= count; i += 4)
+        vst1_u16((uint16_t *) (destination + i), vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(source + i))));
+#endif
+    for (; i < count; i++)
+        destination[i].bits = floatToHalf(source[i]);
+}
+
+void packSnorm16(const float *source, int16_t *destination, size_t count) {
+    size_t i = 0;
+#if defined(OPENGL_PACKING_SSE2)
+    const __m128 scale = _mm_set1_ps(32767.f);
+    for (; i + 8 <= count; i += 8) {
+        __m128i low = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i), scale));
+        __m128i high = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i + 4), scale));
+        _mm_storeu_si128((__m128i *) (destination + i), _mm_packs_epi32(low, high));
+    }
+#elif defined(OPENGL_PACKING_NEON)
+    const float32x4_t lower = vdupq_n_f32(-1.f), upper = vdupq_n_f32(1.f);
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t low = vcvtnq_s32_f32(vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(source + i), lower), upper), 32767.f));
+        int32x4_t high = vcvtnq_s32_f32(vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(source + i + 4), lower), upper), 32767.f));
+        vst1q_s16(destination + i, vcombine_s16(vqmovn_s32(low), vqmovn_s32(high)));
+    }
+#endif
+    for (; i < count; i++)
+        destination[i] = (int16_t) std::lrintf(clampSnorm(source[i]) * 32767.f);
+}
+
+void packSnorm8(const float *source, int8_t *destination, size_t count) {
+    size_t i = 0;
+#if defined(OPENGL_PACKING_SSE2)
+    const __m128 scale = _mm_set1_ps(127.f);
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i), scale));
+        __m128i b = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i + 4), scale));
+        __m128i c = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i + 8), scale));
+        __m128i d = _mm_cvtps_epi32(clampScaleSSE(_mm_loadu_ps(source + i + 12), scale));
+        _mm_storeu_si128((__m128i *) (destination + i),
+                         _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+    }
+#elif defined(OPENGL_PACKING_NEON)
+    const float32x4_t lower = vdupq_n_f32(-1.f), upper = vdupq_n_f32(1.f);
+    for (; i + 8 <= count; i += 8) {
+        int32x4_t low = vcvtnq_s32_f32(vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(source + i), lower), upper), 127.f));
+        int32x4_t high = vcvtnq_s32_f32(vmulq_n_f32(vminq_f32(vmaxq_f32(vld1q_f32(source + i + 4), lower), upper), 127.f));
+        vst1_s8(destination + i, vqmovn_s16(vcombine_s16(vqmovn_s32(low), vqmovn_s32(high))));
+    }
+#endif
+    for (; i < count; i++)
+        destination[i] = (int8_t) std::lrintf(clampSnorm(source[i]) * 127.f);
+}
+
+void packInt2101010(const float *source, unsigned int components, int2_10_10_10 *destination, size_t count) {
+    size_t i = 0;
+#ifdef OPENGL_PACKING_SSE2
+    /* Four vectors at a time, transposed so each register holds one component of all four */
+    const __m128 scale = _mm_set1_ps(511.f);
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    for (; i + 4 <= count; i += 4) {
+        const float *v = source + i * components;
+        const unsigned int c = components;
+        __m128i x = _mm_cvtps_epi32(clampScaleSSE(_mm_setr_ps(v[0], v[c], v[2 * c], v[3 * c]), scale));
+        __m128i y = _mm_cvtps_epi32(clampScaleSSE(_mm_setr_ps(v[1], v[c + 1], v[2 * c + 1], v[3 * c + 1]), scale));
+        __m128i z = _mm_cvtps_epi32(clampScaleSSE(_mm_setr_ps(v[2], v[c + 2], v[2 * c + 2], v[3 * c + 2]), scale));
+        __m128i w = _mm_setzero_si128();
+        if (components == 4)
+            w = _mm_cvtps_epi32(clampScaleSSE(_mm_setr_ps(v[3], v[7], v[11], v[15]), _mm_set1_ps(1.f)));
+
+        __m128i packed = _mm_or_si128(
+                _mm_or_si128(_mm_and_si128(x, mask), _mm_slli_epi32(_mm_and_si128(y, mask), 10)),
+                _mm_or_si128(_mm_slli_epi32(_mm_and_si128(z, mask), 20), _mm_slli_epi32(w, 30)));
+        _mm_storeu_si128((__m128i *) (destination + i), packed);
+    }
+#endif
+    for (; i < count; i++) {
+        const float *v = source + i * components;
+        auto x = (uint32_t) std::lrintf(clampSnorm(v[0]) * 511.f) & 0x3FF;
+        auto y = (uint32_t) std::lrintf(clampSnorm(v[1]) * 511.f) & 0x3FF;
+        auto z = (uint32_t) std::lrintf(clampSnorm(v[2]) * 511.f) & 0x3FF;
+        auto w = components == 4 ? (uint32_t) std::lrintf(clampSnorm(v[3])) & 0x3 : 0u;
+        destination[i].bits = x | (y << 10) | (z << 20) | (w << 30);
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef OPENGL_VERTEXPACKING_H
+#define OPENGL_VERTEXPACKING_H
+
+#include <cstddef>
+#include <cstdint>
+
+/* Storage types for packed attributes, pushed onto a VertexBufferLayout like float or unsigned char.
+ * short and signed char are pushed as normalised to [-1, 1] */
+struct half {
+    uint16_t bits;
+};
+
+/* A signed normalised vec4 in one word: x, y, z in 10 bits each and w in the top 2 (GL_INT_2_10_10_10_REV) */
+struct int2_10_10_10 {
+    uint32_t bits;
+};
+
+/* Encoders from float arrays, using F16C/SSE2 on x86 and NEON on AArch64 with a scalar tail.
+ * Normalised outputs clamp to [-1, 1] first and round to nearest, NaN encodes as -1 */
+void packHalf(const float *source, half *destination, size_t count);
+void packSnorm16(const float *source, int16_t *destination, size_t count);
+void packSnorm8(const float *source, int8_t *destination, size_t count);
+/* [count] vectors of [components] (3 or 4) floats each; a missing w is stored as 0 */
+void packInt2101010(const float *source, unsigned int components, int2_10_10_10 *destination, size_t count);
+
+#endif //OPENGL_VERTEXPACKING_H
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include "VertexPuller.h"
+#include "Renderer.h"
+#include "Shader.h"
+
+/* Helpers shared by every format. pullBits reads [size] bytes at a byte address, spanning two words when
+ * a component isn't aligned to its size (a float after three bytes, say) */
+static const char *PULL_HELPERS = R"(uniform usamplerBuffer u_PulledVertices;
+
+uint pullWord(uint address) { return texelFetch(u_PulledVertices, int(address)).r; }
+
+uint pullBits(uint address, uint size)
+{
+    uint word = address >> 2u, shift = (address & 3u) * 8u;
+    uint value = pullWord(word) >> shift;
+    if (shift + size * 8u > 32u)
+        value |= pullWord(word + 1u) << (32u - shift);
+    return size == 4u ? value : value & ((1u << (size * 8u)) - 1u);
+}
+
+int pullSigned(uint bits, uint width) { return int(bits << (32u - width)) >> (32u - width); }
+
+float pullSnorm(uint bits, uint width)
+{
+    return max(float(pullSigned(bits, width)) / float((1 << (width - 1u)) - 1), -1.0);
+}
+
+float pullHalf(uint bits)
+{
+    uint sign = (bits & 0x8000u) << 16u, exponent = (bits >> 10u) & 0x1Fu, mantissa = bits & 0x3FFu;
+    if (exponent == 0u)
+        return uintBitsToFloat(sign | 0x3F800000u) * float(mantissa) * exp2(-24.0);
+    if (exponent == 31u)
+        return uintBitsToFloat(sign | 0x7F800000u | (mantissa << 13u));
+    return uintBitsToFloat(sign | ((exponent + 112u) << 23u) | (mantissa << 13u));
+}
+
+uint pullVertex() { return pullWord(uint(gl_VertexID)); }
+)";
+
+/* GLSL expression for component [component] of [element], for a vertex whose first byte is `address` */
+static std::string decodeComponent(const VertexBufferElement &element, unsigned int component) {
+    std::string address = "address + " + std::to_string(element.offset) + "u";
+    if (element.type != GL_INT_2_10_10_10_REV) /* All four components share one word */
+        address += " + " + std::to_string(component * VertexBufferElement::getSizeOfType(element.type)) + "u";
+
+    switch (element.type) {
+        case GL_FLOAT:
+            return "uintBitsToFloat(pullBits(" + address + ", 4u))";
+        case GL_UNSIGNED_INT:
+            return "float(pullBits(" + address + ", 4u))";
+        case GL_UNSIGNED_BYTE:
+            return element.normalised ? "float(pullBits(" + address + ", 1u)) / 255.0"
+                                      : "float(pullBits(" + address + ", 1u))";
+        case GL_HALF_FLOAT:
+            return "pullHalf(pullBits(" + address + ", 2u))";
+        case GL_SHORT:
+            return element.normalised ? "pullSnorm(pullBits(" + address + ", 2u), 16u)"
+                                      : "float(pullSigned(pullBits(" + address + ", 2u), 16u))";
+        case GL_BYTE:
+            return element.normalised ? "pullSnorm(pullBits(" + address + ", 1u), 8u)"
+                                      : "float(pullSigned(pullBits(" + address + ", 1u), 8u))";
+        case GL_INT_2_10_10_10_REV: {
+            std::string bits = "(pullBits(" + address + ", 4u) >> " + std::to_string(component * 10) + "u)";
+            if (component == 3)
+                return element.normalised ? "pullSnorm(" + bits + ", 2u)" : "float(pullSigned(" + bits + ", 2u))";
+            bits = "(" + bits + " & 0x3FFu)";
+            return element.normalised ? "pullSnorm(" + bits + ", 10u)" : "float(pullSigned(" + bits + ", 10u))";
+        }
+    }
+    ASSERT(false);
+    return "0.0";
+}
+
+VertexPuller::VertexPuller(unsigned int capacityWords) :
+    m_Buffer(nullptr, std::min(capacityWords, MAX_WORDS) * 4),
+    m_TextureID(0),
+    m_Allocator(std::min(capacityWords, MAX_WORDS)) {
+    if (capacityWords > MAX_WORDS)
+        std::cout << "Warning: vertex puller capacity clamped to " << MAX_WORDS << " words" << std::endl;
+
+    int maxTexels = 0;
+    GLCall(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels));
+    if ((unsigned int) maxTexels < m_Allocator.getCapacity())
+        std::cout << "Warning: vertex puller holds " << m_Allocator.getCapacity()
+                  << " words but texture buffers are limited to " << maxTexels << std::endl;
+
+    GLCall(glGenTextures(1, &m_TextureID));
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, m_TextureID));
+    GLCall(glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_Buffer.getRendererID()));
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, 0));
+}
+
+VertexPuller::~VertexPuller() {
+    GLCall(glDeleteTextures(1, &m_TextureID));
+}
+
+unsigned int VertexPuller::addFormat(const VertexBufferLayout &layout) {
+    ASSERT(m_Formats.size() < MAX_FORMATS);
+    for (const VertexBufferElement &element: layout.GetElement()) {
+        if (element.divisor != 0)
+            std::cout << "Warning: pulled vertices are fetched per vertex, divisor of location "
+                      << element.location << " is ignored" << std::endl;
+    }
+
+    m_Formats.push_back({layout.GetElement(), layout.getStride(), (layout.getStride() + 3) / 4});
+    return (unsigned int) m_Formats.size() - 1;
+}
+
+std::optional<PulledMesh> VertexPuller::allocate(unsigned int format, const void *vertices, unsigned int vertexCount,
+                                                 const unsigned int *indices, unsigned int indexCount) {
+    const Format &layout = m_Formats[format];
+    unsigned int vertexWords = vertexCount * layout.strideWords;
+
+    unsigned int firstVertexWord = m_Allocator.allocate(vertexWords);
+    if (firstVertexWord == FreeListAllocator::INVALID_OFFSET)
+        return std::nullopt;
+
+    unsigned int firstIndex = m_Allocator.allocate(indexCount);
+    if (firstIndex == FreeListAllocator::INVALID_OFFSET) {
+        m_Allocator.free(firstVertexWord, vertexWords);
+        return std::nullopt;
+    }
+
+    if (layout.stride == layout.strideWords * 4) {
+        m_Buffer.setSubData(firstVertexWord * 4, vertices, vertexWords * 4);
+    } else {
+        /* Pad each vertex out to a whole number of words */
+        std::vector<unsigned char> padded(vertexWords * 4);
+        for (unsigned int vertex = 0; vertex < vertexCount; vertex++)
+            memcpy(&padded[vertex * layout.strideWords * 4],
+                   (const unsigned char *) vertices + vertex * layout.stride, layout.stride);
+        m_Buffer.setSubData(firstVertexWord * 4, padded.data(), vertexWords * 4);
+    }
+
+    std::vector<unsigned int> references(indexCount);
+    for (unsigned int i = 0; i < indexCount; i++)
+        references[i] = (format << 24) | (firstVertexWord + indices[i] * layout.strideWords);
+    m_Buffer.setSubData(firstIndex * 4, references.data(), indexCount * 4);
+
+    return PulledMesh{format, firstVertexWord, vertexWords, firstIndex, indexCount};
+}
+
+void VertexPuller::free(const PulledMesh &mesh) {
+    m_Allocator.free(mesh.firstVertexWord, mesh.vertexWords);
+    m_Allocator.free(mesh.firstIndex, mesh.indexCount);
+}
+
+std::string VertexPuller::generateFetchCode() const {
+    /* location -> (format, element) for every format that feeds it */
+    std::map<unsigned int, std::vector<std::pair<unsigned int, const VertexBufferElement *>>> locations;
+    for (unsigned int format = 0; format < m_Formats.size(); format++) {
+        for (const VertexBufferElement &element: m_Formats[format].elements)
+            locations[element.location].emplace_back(format, &element);
+    }
+
+    std::ostringstream code;
+    code << PULL_HELPERS;
+    for (const auto &[location, sources]: locations) {
+        code << "\nvec4 pullAttribute" << location << "(uint vertex)\n{\n"
+             << "    uint address = (vertex & 0xFFFFFFu) * 4u;\n"
+             << "    switch (vertex >> 24u) {\n";
+        for (const auto &[format, element]: sources) {
+            code << "        case " << format << "u: return vec4(";
+            for (unsigned int component = 0; component < 4; component++) {
+                if (component < element->count)
+                    code << decodeComponent(*element, component);
+                else
+                    code << (component == 3 ? "1.0" : "0.0");
+                code << (component < 3 ? ", " : ");\n");
+            }
+        }
+        code << "    }\n    return vec4(0.0, 0.0, 0.0, 1.0);\n}\n";
+    }
+    return code.str();
+}
+
+void VertexPuller::injectFetchCode(ShaderProgramSource &source) const {
+    std::string &vertex = source.VertexSource;
+    size_t version = vertex.find("#version");
+    size_t insertAt = version == std::string::npos ? 0 : vertex.find('\n', version);
+    insertAt = insertAt == std::string::npos ? vertex.size() : insertAt + 1;
+    vertex.insert(insertAt, generateFetchCode());
+}
+
+void VertexPuller::bind(unsigned int textureUnit) const {
+    GLCall(glActiveTexture(GL_TEXTURE0 + textureUnit));
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, m_TextureID));
+    m_EmptyVertexArray.bind();
+}
@@ -0,0 +1,73 @@
+#ifndef OPENGL_VERTEXPULLER_H
+#define OPENGL_VERTEXPULLER_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "FreeListAllocator.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+
+struct ShaderProgramSource;
+
+/* A mesh stored in a VertexPuller. Its indices were expanded on upload, so it is drawn as a non-indexed
+ * range of [indexCount] vertices starting at [firstIndex] */
+struct PulledMesh {
+    unsigned int format;
+    unsigned int firstVertexWord;
+    unsigned int vertexWords;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+/* Programmable vertex pulling: vertices of any number of layouts share one buffer, read in the vertex shader
+ * through a usamplerBuffer instead of attribute pointers, so meshes of different formats go out in a single
+ * glMultiDrawArrays with no VAO changes.
+ * Each index is stored as a reference word, (format << 24) | first word of the vertex, and gl_VertexID selects
+ * the reference; the generated GLSL decodes the vertex from there. Draws are non-indexed as far as GL is
+ * concerned, which gives up the post-transform vertex cache in exchange for the merged submission */
+class VertexPuller {
+private:
+    struct Format {
+        std::vector<VertexBufferElement> elements;
+        unsigned int stride;      /* Bytes, as given by the layout */
+        unsigned int strideWords; /* Stored stride, rounded up so every vertex starts on a word */
+    };
+
+    VertexBuffer m_Buffer;
+    unsigned int m_TextureID;
+    VertexArray m_EmptyVertexArray; /* Core profile draws need some VAO bound */
+    FreeListAllocator m_Allocator;  /* In 32-bit words, shared by vertices and references */
+    std::vector<Format> m_Formats;
+
+public:
+    static constexpr unsigned int MAX_FORMATS = 256;
+    static constexpr unsigned int MAX_WORDS = 1u << 24;
+
+    explicit VertexPuller(unsigned int capacityWords);
+    ~VertexPuller();
+
+    VertexPuller(const VertexPuller &) = delete;
+    VertexPuller &operator=(const VertexPuller &) = delete;
+
+    /* Returns the id to allocate meshes with. Shaders must be generated after every format they read is added */
+    unsigned int addFormat(const VertexBufferLayout &layout);
+
+    /* Returns nothing when the buffer has no block large enough */
+    std::optional<PulledMesh> allocate(unsigned int format, const void *vertices, unsigned int vertexCount,
+                                       const unsigned int *indices, unsigned int indexCount);
+    void free(const PulledMesh &mesh);
+
+    /* GLSL 3.30 declaring `uniform usamplerBuffer u_PulledVertices`, `uint pullVertex()` for the current
+     * vertex's reference, and `vec4 pullAttribute<location>(uint vertex)` for each location any format uses;
+     * missing components read as (0, 0, 0, 1) like unbound attributes */
+    std::string generateFetchCode() const;
+    /* Inserts generateFetchCode() after the #version line of the vertex stage */
+    void injectFetchCode(ShaderProgramSource &source) const;
+
+    /* Binds the data to [textureUnit], where u_PulledVertices must point, and the empty VAO */
+    void bind(unsigned int textureUnit) const;
+};
+
+#endif //OPENGL_VERTEXPULLER_H
@@ -7,9 +7,22 @@
 
 #include "VertexBuffer.h"
 #include "VertexBufferLayout.h"
+#include "VertexLayout.h"
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "Shader.h"
+#include "GLState.h"
+#include "GLExtensions.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderCompiler.h"
+#include "LinmathSIMD.h"
+#include "StreamBuffer.h"
+#include "ThreadPool.h"
+#include "TransformBatch.h"
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
 
 
 void error_callback(int error, const char *description) {
@@ -25,7 +38,10 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 struct Vertex {
     float x, y;
     float r, g, b;
+
+    using Layout = VertexLayout<Attr<float, 2>, Attr<float, 3>>;
 };
+static_assert(offsetof(Vertex, r) == Vertex::Layout::offsets[1]);
 
 Vertex vertices[] = {
         {-0.5f, +0.5f, 1.f, 0.f, 0.f},
@@ -41,7 +57,7 @@ unsigned int indices[]{
 
 int main() {
     GLFWwindow *window;
-    int mvpLocation, vPosLocation, vColLocation;
+    int iMVPLocation, vPosLocation, vColLocation;
 
     /* Setting callback for error */
     glfwSetErrorCallback(error_callback);
@@ -53,6 +69,9 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifndef NDEBUG
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+#endif
 
     window = glfwCreateWindow(640, 480, "Simple Example", nullptr, nullptr);
     if (!window) {
@@ -60,6 +79,10 @@ int main() {
         exit(EXIT_FAILURE);
     }
 
+    /* Hidden window whose context shares objects with [window], so shaders can be compiled on another thread */
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *compileWindow = glfwCreateWindow(1, 1, "", nullptr, window);
+
     /* Creating an OpenGL context and making [window] own it
      * OpenGL context needed to be able to use OpenGL API
      * Context will remain current till another context is made or window owning the current context is destroyed */
@@ -72,6 +95,14 @@ int main() {
 
     /* An extension library that needs access to context*/
     gladLoadGL(glfwGetProcAddress);
+    loadGLExtensions(glfwGetProcAddress);
+
+    /* Errors are reported by the driver through a callback instead of polling glGetError after every call */
+    if (!GLEnableDebugOutput())
+        fprintf(stderr, "GL_KHR_debug unavailable, GL errors are only reported with OPENGL_GLCALL_CHECKS\n");
+#ifdef VERBOSE
+    fprintf(stderr, "Matrix math: %s\n", simd::getImplementation());
+#endif
 
     /* Callback will be called immediately after the close flag has been set */
     glfwSetWindowCloseCallback(
@@ -79,20 +110,40 @@ int main() {
             [](GLFWwindow *window) { fprintf(stderr, "Closing Window"); }
     );
 
-    Shader shader("res/shaders/Basic.shader");
+    /* Linked programs are kept on disk so later launches skip compiling */
+    ProgramBinaryCache binaryCache(".shadercache");
+
+    /* Uses KHR_parallel_shader_compile when available, otherwise a worker thread on [compileWindow]'s context */
+    auto compiler = std::make_unique<ShaderCompiler>(
+            compileWindow ? [compileWindow](bool current) {
+                glfwMakeContextCurrent(current ? compileWindow : nullptr);
+            } : std::function<void(bool)>());
+
+    /* Returns immediately; the location queries below are the first thing to wait for the program */
+    Shader shader("res/shaders/Instanced.shader", *compiler, &binaryCache);
     shader.bind();
-    mvpLocation = shader.getUniformLocation("u_MVP");
+    iMVPLocation = shader.getAttributeLocation("iMVP");
     vPosLocation = shader.getAttributeLocation("vPos");
     vColLocation = shader.getAttributeLocation("vCol");
 
 
     VertexArray vertexArray;
     VertexBuffer vertexBuffer(vertices, 4 * sizeof(Vertex));
-    VertexBufferLayout layout;
-    layout.Push<float>(2, vPosLocation);
-    layout.Push<float>(3, vColLocation);
+    VertexBufferLayout layout = makeVertexLayout<Vertex>({(unsigned int) vPosLocation, (unsigned int) vColLocation});
     vertexArray.addBuffer(vertexBuffer, layout);
 
+    /* One MVP per quad, advanced once per instance instead of once per vertex */
+    static constexpr int GRID_SIZE = 128;
+    static constexpr int INSTANCE_COUNT = GRID_SIZE * GRID_SIZE;
+    TransformBatch transforms;
+    transforms.resize(INSTANCE_COUNT);
+
+    /* MVPs are written straight into the mapped buffer, a few frames' worth so the GPU can lag behind */
+    StreamBuffer instanceStream(GL_ARRAY_BUFFER, 3 * INSTANCE_COUNT * sizeof(mat4x4));
+    VertexBufferLayout instanceLayout;
+    instanceLayout.Push<mat4x4>(1, iMVPLocation, 1);
+    ThreadPool threadPool;
+
     IndexBuffer indexBuffer(indices, 6);
 
     /* glfwGetTime() returns time since initialization */
@@ -107,7 +158,7 @@ int main() {
 
     float ratio;
     int width, height;
-    mat4x4 m, p, mvp;
+    mat4x4 p;
 
     mat4x4 eye;
     mat4x4_identity(eye);
@@ -119,27 +170,49 @@ int main() {
     /* Checking the window close flag */
     while (!glfwWindowShouldClose(window)) {
 
-        glViewport(0, 0, width, height);  /* Create buffer of certain size */
+        GLState::get().viewport(0, 0, width, height);  /* Create buffer of certain size */
         renderer.clear();
 
-        mat4x4_identity(m); /* Initialization to identity matrix */
-        mat4x4_rotate_Z(m, m, (float) current_time()); /* Rotating matrix by angle of time */
         mat4x4_ortho(p, -ratio, ratio, -1.f, 1.f, 1.f, -1.f); /* Project in orthogonal view */
-        mat4x4_mul(mvp, p, m); /* Final Matrix after rotation and projection */
-
-        shader.bind();
 
-        /* Uniforms are used to send data to shaders from cpu
-         * Uniforms are set per draw where attributes are set per vertex  */
-        shader.setUniformMat4x4(mvpLocation, mvp);
-
-        renderer.draw(vertexArray, indexBuffer, shader);
+        /* Every quad spins about its own centre by the angle of time */
+        float angle = (float) current_time();
+        for (int i = 0; i < INSTANCE_COUNT; i++) {
+            vec3 position = {(((float) (i % GRID_SIZE) + 0.5f) / GRID_SIZE * 2.f - 1.f) * ratio,
+                             ((float) (i / GRID_SIZE) + 0.5f) / GRID_SIZE * 2.f - 1.f, 0.f};
+            quat rotation = {0.f, 0.f, sinf(angle * 0.5f), cosf(angle * 0.5f)};
+            vec3 scale = {1.f / GRID_SIZE, 1.f / GRID_SIZE, 1.f};
+            transforms.set(i, position, rotation, scale);
+        }
+
+        /* Final Matrices after rotation and projection, computed across the pool into this frame's slice.
+         * Attributes are normally set per vertex, the instance data is stepped per quad instead
+         * so the whole grid is a single draw call */
+        StreamAllocation instances = instanceStream.allocate(INSTANCE_COUNT * sizeof(mat4x4), sizeof(mat4x4));
+        if (instances.data) {
+            computeTransforms(transforms, p, nullptr, (mat4x4 *) instances.data, &threadPool);
+            instanceStream.commit();
+            vertexArray.addBuffer(instanceStream, instanceLayout, instances.offset);
+            renderer.drawInstanced(vertexArray, indexBuffer, shader, INSTANCE_COUNT);
+        }
+        instanceStream.endFrame();
 
         /* Swapping of buffers after each frame has been rendered */
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+#ifdef VERBOSE
+    fprintf(stderr, "GL state changes issued: %llu, skipped: %llu\n",
+            (unsigned long long) GLState::get().getIssuedCount(),
+            (unsigned long long) GLState::get().getSkippedCount());
+#endif
+
+    /* Joins the worker before its context goes away */
+    compiler.reset();
+    if (compileWindow)
+        glfwDestroyWindow(compileWindow);
+
     /* When a window is no longer needed, destroy it */
     GLCall(glfwDestroyWindow(window));
 